@@ -0,0 +1,301 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <QAudioDeviceInfo>
+#include <QAudioOutput>
+#include <QDebug>
+#include <QFile>
+#include <QIODevice>
+#include <QVarLengthArray>
+#include <QtEndian>
+#include "audiostingers.h"
+#include "trace.h"
+
+// Pulled by QAudioOutput on the stinger thread.
+class StingerMixer : public QIODevice
+{
+public:
+    StingerMixer(AudioStingers *stingers, QAudioOutput *output)
+        : stingers(stingers), output(output) { }
+
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxlen) override
+    {
+        int bytesPerFrame = stingers->format.bytesPerFrame();
+        int frames = int(maxlen / bytesPerFrame);
+        qint64 queued = output->bufferSize() - output->bytesFree();
+        stingers->mix(reinterpret_cast<qint16*>(data), frames,
+                      stingers->format.durationForBytes(std::max(queued, 0ll)));
+        return qint64(frames) * bytesPerFrame;
+    }
+
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    AudioStingers *stingers;
+    QAudioOutput *output;
+};
+
+static quint16 u16(const QByteArray &data, int pos)
+{
+    return qFromLittleEndian<quint16>(data.constData() + pos);
+}
+
+static quint32 u32(const QByteArray &data, int pos)
+{
+    return qFromLittleEndian<quint32>(data.constData() + pos);
+}
+
+// Reads a RIFF WAVE file into interleaved samples in [-1, 1].
+static bool readWav(const QByteArray &data, QVector<float> *samples,
+                    int *channels, int *rate, QString *error)
+{
+    if (data.size() < 12 || !data.startsWith("RIFF") || data.mid(8, 4) != "WAVE") {
+        *error = "not a WAV file";
+        return false;
+    }
+    int format = 0;
+    int bits = 0;
+    int dataPos = -1;
+    int dataLength = 0;
+    *channels = 0;
+    *rate = 0;
+    for (int pos = 12; pos + 8 <= data.size(); ) {
+        QByteArray id = data.mid(pos, 4);
+        int body = pos + 8;
+        int length = int(std::min<quint32>(u32(data, pos + 4), data.size() - body));
+        if (id == "fmt " && length >= 16) {
+            format = u16(data, body);
+            *channels = u16(data, body + 2);
+            *rate = int(u32(data, body + 4));
+            bits = u16(data, body + 14);
+            // WAVE_FORMAT_EXTENSIBLE names the real format in its subformat.
+            if (format == 0xfffe && length >= 26)
+                format = u16(data, body + 24);
+        } else if (id == "data") {
+            dataPos = body;
+            dataLength = length;
+        }
+        pos = body + length + (length & 1);
+    }
+    bool integer = format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+    bool floating = format == 3 && bits == 32;
+    if (!(integer || floating) || *channels <= 0 || *rate <= 0 || dataPos < 0) {
+        *error = "unsupported WAV format";
+        return false;
+    }
+
+    int bytes = bits / 8;
+    int count = dataLength / bytes / *channels * *channels;
+    samples->resize(count);
+    const uchar *p = reinterpret_cast<const uchar*>(data.constData() + dataPos);
+    for (int i = 0; i < count; i++, p += bytes) {
+        float v;
+        if (floating) {
+            quint32 word = qFromLittleEndian<quint32>(p);
+            std::memcpy(&v, &word, sizeof v);
+        }
+        else if (bits == 8)
+            v = (p[0] - 128) / 128.0f;
+        else if (bits == 16)
+            v = qFromLittleEndian<qint16>(p) / 32768.0f;
+        else if (bits == 24)
+            v = qint32(quint32(p[0]) << 8 | quint32(p[1]) << 16 | quint32(p[2]) << 24)
+                    / 2147483648.0f;
+        else
+            v = qFromLittleEndian<qint32>(p) / 2147483648.0f;
+        (*samples)[i] = v;
+    }
+    return true;
+}
+
+AudioStingers::AudioStingers(QObject *parent) : QThread(parent)
+{
+    clock.start();
+    format.setSampleRate(48000);
+    format.setChannelCount(2);
+    format.setSampleSize(16);
+    format.setCodec("audio/pcm");
+    format.setByteOrder(QAudioFormat::LittleEndian);
+    format.setSampleType(QAudioFormat::SignedInt);
+    QAudioDeviceInfo device = QAudioDeviceInfo::defaultOutputDevice();
+    if (!device.isNull() && !device.isFormatSupported(format)) {
+        QAudioFormat nearest = device.nearestFormat(format);
+        format.setSampleRate(nearest.sampleRate());
+        format.setChannelCount(std::min(std::max(nearest.channelCount(), 1), 2));
+    }
+}
+
+AudioStingers::~AudioStingers()
+{
+    quit();
+    wait();
+}
+
+bool AudioStingers::load(const QString &name, const QString &filename, QString *error)
+{
+    TRACE_SPAN("stinger.load");
+    QFile f(filename);
+    if (!f.open(QIODevice::ReadOnly)) {
+        *error = f.errorString();
+        return false;
+    }
+    QVector<float> samples;
+    int channels;
+    int rate;
+    if (!readWav(f.readAll(), &samples, &channels, &rate, error))
+        return false;
+    stingers.insert(name, convert(samples, channels, rate));
+    accountSamples();
+    return true;
+}
+
+// A struck bell: a fundamental and a fainter inharmonic partial, both
+// decaying.
+void AudioStingers::loadChime(const QString &name, double frequency, int msecDuration)
+{
+    int rate = format.sampleRate();
+    int count = rate * msecDuration / 1000;
+    QVector<float> samples(count);
+    for (int i = 0; i < count; i++) {
+        double t = double(i) / rate;
+        double attack = std::min(t / 0.005, 1.0);
+        double decay = std::exp(-t * 6000.0 / msecDuration);
+        samples[i] = float(0.4 * attack * decay
+                           * (std::sin(2 * M_PI * frequency * t)
+                              + 0.3 * std::sin(2 * M_PI * frequency * 2.76 * t)));
+    }
+    stingers.insert(name, convert(samples, 1, rate));
+    accountSamples();
+}
+
+void AudioStingers::accountSamples()
+{
+    qint64 bytes = 0;
+    for (const Samples &samples : qAsConst(stingers))
+        bytes += samples->size() * qint64(sizeof(qint16));
+    sampleMemory.set(bytes);
+}
+
+bool AudioStingers::contains(const QString &name) const
+{
+    return stingers.contains(name);
+}
+
+void AudioStingers::play(const QString &name)
+{
+    Samples samples = stingers.value(name);
+    if (!samples || samples->isEmpty())
+        return;
+    QMutexLocker lock(&mutex);
+    voices.append({ name, samples, 0, clock.nsecsElapsed() });
+}
+
+QString AudioStingers::statsText() const
+{
+    QMutexLocker lock(&mutex);
+    if (!playCount)
+        return QString();
+    return tr("Stinger latency: %1 ms last, %2 ms max")
+            .arg(lastLatency, 0, 'f', 1).arg(maxLatency, 0, 'f', 1);
+}
+
+void AudioStingers::run()
+{
+    QAudioOutput output(QAudioDeviceInfo::defaultOutputDevice(), format);
+    output.setBufferSize(format.bytesForDuration(bufferMsec * 1000));
+    StingerMixer mixer(this, &output);
+    mixer.open(QIODevice::ReadOnly);
+    output.start(&mixer);
+    if (output.error() != QAudio::NoError) {
+        qWarning() << "stingers: audio output unavailable, error" << output.error();
+        return;
+    }
+    exec();
+    output.stop();
+}
+
+// Interleaved samples at the mix rate and channel count, resampled
+// linearly; fine for chimes, and done once per load.
+AudioStingers::Samples AudioStingers::convert(const QVector<float> &input,
+                                              int channels, int rate) const
+{
+    int outChannels = format.channelCount();
+    int frames = input.count() / channels;
+    int outFrames = int(qint64(frames) * format.sampleRate() / rate);
+    auto *out = new QVector<qint16>(outFrames * outChannels);
+    auto sample = [&](int frame, int c) {
+        frame = std::min(frame, frames - 1);
+        if (outChannels == 1 && channels > 1) {
+            float sum = 0;
+            for (int i = 0; i < channels; i++)
+                sum += input[frame * channels + i];
+            return sum / channels;
+        }
+        return input[frame * channels + std::min(c, channels - 1)];
+    };
+    for (int i = 0; i < outFrames; i++) {
+        double at = double(i) * rate / format.sampleRate();
+        int frame = int(at);
+        float t = float(at - frame);
+        for (int c = 0; c < outChannels; c++) {
+            float v = sample(frame, c) * (1 - t) + sample(frame + 1, c) * t;
+            (*out)[i * outChannels + c] = qint16(std::max(-1.0f, std::min(v, 1.0f)) * 32767);
+        }
+    }
+    return Samples(out);
+}
+
+void AudioStingers::mix(qint16 *out, int frames, qint64 queuedUsec)
+{
+    int count = frames * format.channelCount();
+    QVarLengthArray<qint32, 4096> sum(count);
+    std::fill(sum.begin(), sum.end(), 0);
+    QList<QPair<QString,double>> started;
+
+    mutex.lock();
+    for (auto v = voices.begin(); v != voices.end(); ) {
+        if (v->position == 0) {
+            // Everything queued ahead of this buffer plays first.
+            double latency = (clock.nsecsElapsed() - v->triggeredNsec) / 1e6
+                    + queuedUsec / 1e3;
+            lastLatency = latency;
+            maxLatency = std::max(maxLatency, latency);
+            playCount++;
+            started.append({ v->name, latency });
+        }
+        int n = std::min(count, v->samples->count() - v->position);
+        const qint16 *s = v->samples->constData() + v->position;
+        for (int i = 0; i < n; i++)
+            sum[i] += s[i];
+        v->position += n;
+        if (v->position >= v->samples->count())
+            v = voices.erase(v);
+        else
+            ++v;
+    }
+    mutex.unlock();
+
+    for (int i = 0; i < count; i++)
+        out[i] = qint16(std::max(-32768, std::min(sum[i], 32767)));
+    for (const auto &s : started)
+        emit played(s.first, s.second);
+}
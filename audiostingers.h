@@ -0,0 +1,86 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef AUDIOSTINGERS_H
+#define AUDIOSTINGERS_H
+
+#include <QAudioFormat>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThread>
+#include <QVector>
+#include "memorybudget.h"
+
+// Short sounds played on countdown thresholds and cues.  Stingers are
+// decoded and resampled to the mix format when they are loaded, so playing
+// one only adds it to the mix.  The output runs all the time on its own
+// thread with a short buffer, pulling silence between stingers, so that
+// no device or decoder has to start when a stinger is due.  The delay from
+// play() until its first sample has played out is measured for each play.
+class AudioStingers : public QThread
+{
+    Q_OBJECT
+public:
+    // Must be constructed on the GUI thread.
+    explicit AudioStingers(QObject *parent = nullptr);
+    ~AudioStingers();
+
+    // WAV files only: integer PCM of 8 to 32 bits, or 32-bit float.
+    bool load(const QString &name, const QString &filename, QString *error);
+    void loadChime(const QString &name, double frequency, int msecDuration);
+    bool contains(const QString &name) const;
+    void play(const QString &name);
+
+    QString statsText() const;
+
+signals:
+    void played(const QString &name, double msecLatency);
+
+protected:
+    void run() override;
+
+private:
+    friend class StingerMixer;
+    typedef QSharedPointer<const QVector<qint16>> Samples;
+
+    struct Voice {
+        QString name;
+        Samples samples;
+        int position;
+        qint64 triggeredNsec;
+    };
+
+    Samples convert(const QVector<float> &input, int channels, int rate) const;
+    void mix(qint16 *out, int frames, qint64 queuedUsec);
+    void accountSamples();
+
+    static constexpr int bufferMsec = 20;
+
+    QAudioFormat format;
+    QHash<QString,Samples> stingers;
+    MemoryBudget::Account sampleMemory { MemoryBudget::StingerAudio };
+    QElapsedTimer clock;
+
+    mutable QMutex mutex;
+    QList<Voice> voices;
+    int playCount = 0;
+    double lastLatency = 0;
+    double maxLatency = 0;
+};
+
+#endif // AUDIOSTINGERS_H
@@ -32,6 +32,7 @@ Countdown::Countdown(Countdown &c) : QObject()
     endTime = c.endTime;
     duration = c.duration;
     timer = c.timer;
+    storeId = c.storeId;
 }
 
 Countdown::~Countdown()
@@ -86,3 +87,50 @@ void Countdown::writeSettings(QSettings &settings)
     settings.setValue(settingEndTime, endTime);
     settings.setValue(settingDuration, duration);
 }
+
+void Countdown::readStream(QDataStream &stream)
+{
+    qint32 day;
+    stream >> day >> endTime >> duration;
+    dayOfWeek = day;
+}
+
+void Countdown::writeStream(QDataStream &stream) const
+{
+    stream << qint32(dayOfWeek) << endTime << duration;
+}
+
+QString Cue::toString() const
+{
+    if (kind == CountdownCue)
+        return QString("Countdown %1").arg(QTime(0,0).addMSecs(msecDuration)
+                                           .toString());
+    if (msecIn || msecOut) {
+        auto time = [](int msec) {
+            return msec ? QTime(0,0).addMSecs(msec).toString("H:mm:ss.zzz")
+                        : QString();
+        };
+        return QString("%1 [%2 - %3]").arg(filename, time(msecIn), time(msecOut));
+    }
+    return filename;
+}
+
+// In and out points were added later; older records end before them.
+void Cue::readStream(QDataStream &stream)
+{
+    quint8 k;
+    qint32 msec, in = 0, out = 0;
+    stream >> k >> filename >> msec;
+    if (!stream.atEnd())
+        stream >> in >> out;
+    kind = Kind(k);
+    msecDuration = msec;
+    msecIn = in;
+    msecOut = out;
+}
+
+void Cue::writeStream(QDataStream &stream) const
+{
+    stream << quint8(kind) << filename << qint32(msecDuration)
+           << qint32(msecIn) << qint32(msecOut);
+}
@@ -42,9 +42,35 @@ public:
     QTime endTime;
     QTime duration;
     QSharedPointer<QTimer> timer;
+    quint32 storeId = 0;
 
     void readSettings(QSettings &settings);
     void writeSettings(QSettings &settings);
+    void readStream(QDataStream &stream);
+    void writeStream(QDataStream &stream) const;
+};
+
+// One entry in the running order of a cue list.
+struct Cue {
+    enum Kind : quint8 { CountdownCue, StillCue, VideoCue };
+
+    Kind kind = StillCue;
+    QString filename;
+    int msecDuration = 0;   // countdowns only
+    int msecIn = 0;         // videos only; 0 plays from the start
+    int msecOut = 0;        // videos only; 0 plays to the end
+    quint32 storeId = 0;
+
+    QString toString() const;
+    void readStream(QDataStream &stream);
+    void writeStream(QDataStream &stream) const;
+};
+
+// Demuxer cache settings for video, tuned for network streams.
+struct StreamCache {
+    qint64 bytes = 150 * 1024 * 1024;   // mpv's own default
+    double readaheadSecs = 20;
+    double prebufferSecs = 3;           // before showing and after underruns
 };
 
 #endif // COMMON_H
@@ -0,0 +1,298 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QCoreApplication>
+#include <QLocalSocket>
+#include <QSet>
+#include <QSettings>
+#include <QTimer>
+#include "controlserver.h"
+#include "displaywidget.h"
+#include "trace.h"
+
+// Commands waiting longer than this for their frame are answered with an
+// error, e.g. when the file could not be shown.
+constexpr qint64 replyTimeoutMsec = 10000;
+constexpr int maxLineLength = 4096;
+
+static const char settingControlSocket[] = "controlSocket";
+
+// Cues may be live on any of the displays, so each one resolves waits.
+ControlServer::ControlServer(const QList<DisplayWidget*> &displays, QObject *parent)
+    : QObject(parent)
+{
+    server.setSocketOptions(QLocalServer::UserAccessOption);
+    connect(&server, &QLocalServer::newConnection,
+            this, &ControlServer::newConnection);
+    for (DisplayWidget *display : displays) {
+        connect(display, &DisplayWidget::framePainted,
+                this, [this]() { resolve(WaitFrame); });
+        connect(display, &DisplayWidget::fadedOut,
+                this, [this]() { resolve(WaitFadeOut); });
+    }
+    auto *timer = new QTimer(this);
+    connect(timer, &QTimer::timeout, this, &ControlServer::expire);
+    timer->start(1000);
+}
+
+ControlServer::~ControlServer()
+{
+    server.close();
+}
+
+// One socket per application and user, so that the test harnesses and
+// other users on a shared machine do not collide.
+QString ControlServer::defaultName()
+{
+    QString user = qEnvironmentVariable("USER", qEnvironmentVariable("USERNAME"));
+    return QString("%1-%2").arg(QCoreApplication::applicationName().toLower(), user);
+}
+
+// An empty name turns the control socket off.
+QString ControlServer::configuredName()
+{
+    return QSettings().value(settingControlSocket, defaultName()).toString();
+}
+
+bool ControlServer::listen(const QString &name)
+{
+    if (server.listen(name))
+        return true;
+    // A socket file left behind by a crash makes listen() fail on Unix.
+    if (server.serverError() == QAbstractSocket::AddressInUseError) {
+        QLocalSocket probe;
+        probe.connectToServer(name);
+        if (probe.waitForConnected(100))
+            return false;
+        QLocalServer::removeServer(name);
+        return server.listen(name);
+    }
+    return false;
+}
+
+QString ControlServer::serverName() const
+{
+    return server.fullServerName();
+}
+
+QString ControlServer::errorString() const
+{
+    return server.errorString();
+}
+
+// Runs a command from within the process; there is no one to reply to.
+void ControlServer::execute(const QByteArray &line)
+{
+    dispatch(nullptr, line);
+}
+
+void ControlServer::newConnection()
+{
+    while (QLocalSocket *socket = server.nextPendingConnection()) {
+        connect(socket, &QLocalSocket::readyRead,
+                this, [this, socket]() { readCommands(socket); });
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket]() {
+            for (Pending &p : pending)
+                if (p.socket == socket)
+                    p.socket = nullptr;
+            flush();
+            socket->deleteLater();
+        });
+    }
+}
+
+void ControlServer::readCommands(QLocalSocket *socket)
+{
+    while (socket->canReadLine()) {
+        QByteArray line = socket->readLine(maxLineLength).trimmed();
+        if (!line.isEmpty())
+            dispatch(socket, line);
+    }
+    if (socket->bytesAvailable() > maxLineLength) {
+        socket->write("error line too long\n");
+        socket->disconnectFromServer();
+    }
+}
+
+void ControlServer::dispatch(QLocalSocket *socket, const QByteArray &line)
+{
+    TRACE_SPAN("control.dispatch");
+    Pending p { socket, QElapsedTimer(), NoWait, QByteArray(), nextId++ };
+    p.received.start();
+
+    int space = line.indexOf(' ');
+    QByteArray command = line.left(space);
+    QByteArray rest = space < 0 ? QByteArray() : line.mid(space + 1).trimmed();
+    QList<QByteArray> args = rest.split(' ');
+    bool ok = true;
+    auto seconds = [&](int i) {
+        bool valid = i < args.count();
+        double s = valid ? args[i].toDouble(&valid) : 0;
+        ok = ok && valid && s >= 0;
+        return int(s * 1000);
+    };
+
+    if (command == "countdown") {
+        int duration = seconds(0);
+        if (ok) {
+            request(p, WaitFrame, [&]() { emit countdownRequested(duration); });
+            return;
+        }
+    } else if (command == "partway") {
+        int position = seconds(0);
+        int duration = seconds(1);
+        if (ok && position < duration) {
+            request(p, WaitFrame, [&]() {
+                emit countdownPartwayRequested(position, duration);
+            });
+            return;
+        }
+    } else if (command == "show" && !rest.isEmpty()) {
+        request(p, WaitFrame, [&]() { emit imageRequested(QString::fromUtf8(rest)); });
+        return;
+    } else if (command == "next" || command == "previous") {
+        request(p, WaitFrame, [&]() { emit stepRequested(command == "next" ? 1 : -1); });
+        return;
+    } else if (command == "item") {
+        int index = rest.toInt(&ok);
+        if (ok) {
+            request(p, WaitFrame, [&]() { emit itemRequested(index); });
+            return;
+        }
+    } else if (command == "stop") {
+        request(p, WaitFadeOut, [&]() { emit stopRequested(); });
+        return;
+    } else if (command == "append" && !rest.isEmpty()) {
+        emit appendRequested(QString::fromUtf8(rest));
+        p.reply = "ok 0\n";
+        pending.append(p);
+        flush();
+        return;
+    } else if (command == "lowerthird" || command == "caption") {
+        QString text = QString::fromUtf8(rest);
+        if (command == "lowerthird")
+            emit textRequested(TextOverlay::LowerThird, text.replace('|', '\n'));
+        else
+            emit textRequested(TextOverlay::Caption, text);
+        p.reply = "ok 0\n";
+        pending.append(p);
+        flush();
+        return;
+    } else if (command == "clock") {
+        if (rest == "on" || rest == "off") {
+            emit clockRequested(rest == "on");
+            p.reply = "ok 0\n";
+            pending.append(p);
+            flush();
+            return;
+        }
+    } else if (command == "raise") {
+        emit raiseRequested();
+        p.reply = "ok 0\n";
+        pending.append(p);
+        flush();
+        return;
+    } else if (command == "ping") {
+        p.reply = "ok 0\n";
+        pending.append(p);
+        flush();
+        return;
+    } else {
+        p.reply = "error unknown command\n";
+        pending.append(p);
+        flush();
+        return;
+    }
+    p.reply = "error bad arguments\n";
+    pending.append(p);
+    flush();
+}
+
+void ControlServer::ignore()
+{
+    ignored = true;
+}
+
+void ControlServer::reject(const QByteArray &reason)
+{
+    rejection = reason;
+}
+
+// Queues the reply before acting, as the frame may be painted at once.
+void ControlServer::request(Pending p, Wait wait, const std::function<void()> &emitRequest)
+{
+    p.wait = wait;
+    pending.append(p);
+    ignored = false;
+    rejection.clear();
+    emitRequest();
+    if (!ignored && rejection.isEmpty())
+        return;
+    for (Pending &q : pending) {
+        if (q.id == p.id) {
+            q.wait = NoWait;
+            q.reply = rejection.isEmpty() ? QByteArray("ok 0\n")
+                                          : "error " + rejection + '\n';
+        }
+    }
+    rejection.clear();
+    flush();
+}
+
+void ControlServer::resolve(Wait event)
+{
+    for (Pending &p : pending) {
+        if (p.wait != event)
+            continue;
+        p.wait = NoWait;
+        p.reply = QByteArray("ok ")
+                + QByteArray::number(p.received.nsecsElapsed() / 1e6, 'f', 2)
+                + '\n';
+    }
+    flush();
+}
+
+// Replies go out in command order, so an answered command waits for the
+// ones before it from the same connection.
+void ControlServer::flush()
+{
+    QSet<QLocalSocket*> blocked;
+    for (int i = 0; i < pending.count();) {
+        Pending &p = pending[i];
+        if (!p.socket) {
+            pending.removeAt(i);
+            continue;
+        }
+        if (p.wait != NoWait || blocked.contains(p.socket)) {
+            blocked.insert(p.socket);
+            i++;
+            continue;
+        }
+        p.socket->write(p.reply);
+        pending.removeAt(i);
+    }
+}
+
+void ControlServer::expire()
+{
+    for (Pending &p : pending) {
+        if (p.wait != NoWait && p.received.elapsed() > replyTimeoutMsec) {
+            p.wait = NoWait;
+            p.reply = "error timeout\n";
+        }
+    }
+    flush();
+}
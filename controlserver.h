@@ -0,0 +1,109 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef CONTROLSERVER_H
+#define CONTROLSERVER_H
+
+#include <functional>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QLocalServer>
+#include <QObject>
+
+class DisplayWidget;
+class QLocalSocket;
+
+// Line protocol on a local socket, for show controllers and scripts on the
+// same machine.  Each line is one command; any number may be sent without
+// waiting.  Replies come back one line per command, in order:
+//     countdown <seconds>              ok <msec to first frame>
+//     partway <position> <duration>    ok <msec to first frame>
+//     show <file>                      ok <msec to first frame>
+//     next | previous | item <n>       ok <msec to first frame>
+//     stop                             ok <msec to faded out>
+//     append <file>                    ok 0
+//     lowerthird [name[|title]]        ok 0
+//     caption [text]                   ok 0
+//     clock on|off                     ok 0
+//     raise                            ok 0
+//     ping                             ok 0
+// or "error <reason>".  A command superseded before its frame was painted
+// is answered when the frame of its successor is.
+class ControlServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ControlServer(const QList<DisplayWidget*> &displays,
+                           QObject *parent = nullptr);
+    ~ControlServer();
+
+    bool listen(const QString &name);
+    QString serverName() const;
+    QString errorString() const;
+
+    void execute(const QByteArray &line);
+    // For handlers of the requests below that leave the output as it is,
+    // e.g. stop with nothing shown; the command is answered at once rather
+    // than waiting for a frame or fade that will not come.
+    void ignore();
+    // For handlers that cannot act on the request at all, e.g. an item
+    // number past the end of the playlist; answers "error <reason>".
+    void reject(const QByteArray &reason);
+
+    static QString defaultName();
+    static QString configuredName();
+
+signals:
+    void countdownRequested(int msecDuration);
+    void countdownPartwayRequested(int msecPosition, int msecDuration);
+    void imageRequested(const QString &filename);
+    void stepRequested(int delta);
+    void itemRequested(int index);
+    void stopRequested();
+    void appendRequested(const QString &filename);
+    void raiseRequested();
+    // block is a TextOverlay::Block; empty text hides it.
+    void textRequested(int block, const QString &text);
+    void clockRequested(bool visible);
+
+private:
+    enum Wait { NoWait, WaitFrame, WaitFadeOut };
+
+    struct Pending {
+        QLocalSocket *socket;
+        QElapsedTimer received;
+        Wait wait;
+        QByteArray reply;
+        quint64 id;
+    };
+
+    void newConnection();
+    void readCommands(QLocalSocket *socket);
+    void dispatch(QLocalSocket *socket, const QByteArray &line);
+    void request(Pending p, Wait wait, const std::function<void()> &emitRequest);
+    void resolve(Wait event);
+    void flush();
+    void expire();
+
+    QLocalServer server;
+    QList<Pending> pending;
+    quint64 nextId = 0;
+    bool ignored = false;
+    QByteArray rejection;
+};
+
+#endif // CONTROLSERVER_H
@@ -0,0 +1,238 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <algorithm>
+#include <cmath>
+#include <QDebug>
+#include <QFontMetricsF>
+#include <QImage>
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+#include <QPainter>
+#include <QTime>
+#include "countdownoverlay.h"
+#include "trace.h"
+
+const char CountdownOverlay::glyphs[] = "0123456789:";
+
+// The same colours as DisplayWidget::paintCountdown.
+static const QColor fillColor(0xff,0xff,0xba);
+static const QColor backColor(0x49,0x49,0x63);
+
+// Positions are in pixels from the top left.  Mode 0 samples the glyph
+// atlas; mode 1 shades the ring, with texCoord spanning [-1,1] over its
+// bounding square.
+static const char vertexShader[] =
+        "attribute highp vec2 position;\n"
+        "attribute highp vec2 texCoord;\n"
+        "uniform highp vec2 target;\n"
+        "varying highp vec2 v;\n"
+        "void main() {\n"
+        "    v = texCoord;\n"
+        "    gl_Position = vec4(position.x / target.x * 2.0 - 1.0,\n"
+        "                       1.0 - position.y / target.y * 2.0, 0.0, 1.0);\n"
+        "}\n";
+
+static const char fragmentShader[] =
+        "uniform int mode;\n"
+        "uniform sampler2D atlas;\n"
+        "uniform lowp vec4 fill;\n"
+        "uniform lowp vec4 back;\n"
+        "uniform highp float factor;\n"
+        "uniform highp float inner;\n"
+        "uniform highp float pixel;\n"
+        "varying highp vec2 v;\n"
+        "void main() {\n"
+        "    if (mode == 0) {\n"
+        "        gl_FragColor = fill * texture2D(atlas, v).a;\n"
+        "        return;\n"
+        "    }\n"
+        "    highp float r = length(v);\n"
+        "    highp float a = (1.0 - smoothstep(1.0 - pixel, 1.0, r))\n"
+        "                  * smoothstep(inner - pixel, inner, r);\n"
+        "    highp float angle = atan(-v.x, -v.y);\n"
+        "    if (angle < 0.0)\n"
+        "        angle += 6.28318531;\n"
+        "    lowp vec4 c = angle <= factor * 6.28318531 ? fill : back;\n"
+        "    gl_FragColor = c * a;\n"
+        "}\n";
+
+CountdownOverlay::CountdownOverlay() : vertexBuffer(QOpenGLBuffer::VertexBuffer)
+{
+
+}
+
+CountdownOverlay::~CountdownOverlay()
+{
+
+}
+
+void CountdownOverlay::release()
+{
+    atlas.reset();
+    program.reset();
+    vertexBuffer.destroy();
+    initialized = false;
+}
+
+bool CountdownOverlay::initialize()
+{
+    initializeOpenGLFunctions();
+    program.reset(new QOpenGLShaderProgram);
+    if (!program->addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader)
+            || !program->addShaderFromSourceCode(QOpenGLShader::Fragment, fragmentShader)
+            || !program->link()) {
+        qWarning() << "countdown overlay:" << program->log();
+        return false;
+    }
+
+    QFont f;
+    f.setFixedPitch(true);
+    f.setBold(true);
+    f.setPixelSize(glyphPixels);
+    QFontMetricsF metrics(f);
+    auto advance = [&metrics](char c) {
+        return metrics.size(Qt::TextSingleLine, QString(c)).width();
+    };
+    glyphAdvance = advance('0');
+    glyphHeight = metrics.height();
+    int count = sizeof(glyphs) - 1;
+    int cell = int(std::ceil(std::max(glyphAdvance, advance(':')))) + 2;
+
+    QImage image(cell * count, int(std::ceil(glyphHeight)) + 2,
+                 QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter p(&image);
+    p.setFont(f);
+    p.setPen(Qt::white);
+    for (int i = 0; i < count; i++) {
+        QRectF r(i * cell + 1, 1, advance(glyphs[i]), glyphHeight);
+        p.drawText(r, Qt::AlignLeft | Qt::AlignTop, QString(glyphs[i]));
+        glyphRects[i] = QRectF(r.x() / image.width(), r.y() / image.height(),
+                               r.width() / image.width(), r.height() / image.height());
+    }
+    p.end();
+
+    atlas.reset(new QOpenGLTexture(image, QOpenGLTexture::GenerateMipMaps));
+    atlas->setMinMagFilters(QOpenGLTexture::LinearMipMapLinear,
+                            QOpenGLTexture::Linear);
+    atlas->setWrapMode(QOpenGLTexture::ClampToEdge);
+
+    vertexBuffer.create();
+    vertexBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    return true;
+}
+
+void CountdownOverlay::paint(const QSize &target, qint64 msecLeft, qint64 msecDuration)
+{
+    TRACE_SPAN("overlay.countdown");
+    if (failed)
+        return;
+    if (!initialized) {
+        initialized = true;
+        if (!initialize()) {
+            failed = true;
+            return;
+        }
+    }
+
+    // Layout as in DisplayWidget::paintCountdown.
+    double w = target.width();
+    double h = target.height();
+    double d = std::min(w, h);
+    QPointF origin = w > h ? QPointF((w - h) / 2, 0) : QPointF(0, (h - w) / 2);
+    double scale = d * 0.2 / glyphPixels;
+
+    // Rounded to the nearest second, as paintCountdown does at 20 fps.
+    int seconds = int(qBound(0ll, (msecLeft + 25) / 1000, 3599ll));
+    QString text = QTime(0, seconds / 60, seconds % 60).toString("m:ss");
+
+    QVector<float> textVertices;
+    double x = origin.x() + d - text.length() * glyphAdvance * scale;
+    double y = origin.y() + (d - glyphHeight * scale) / 2;
+    for (QChar c : text) {
+        int index = c == ':' ? 10 : c.digitValue();
+        const QRectF &t = glyphRects[index];
+        double gw = t.width() / glyphRects[0].width() * glyphAdvance * scale;
+        double gh = glyphHeight * scale;
+        float quad[] = {
+            float(x),      float(y),      float(t.left()),  float(t.top()),
+            float(x + gw), float(y),      float(t.right()), float(t.top()),
+            float(x),      float(y + gh), float(t.left()),  float(t.bottom()),
+            float(x + gw), float(y),      float(t.right()), float(t.top()),
+            float(x + gw), float(y + gh), float(t.right()), float(t.bottom()),
+            float(x),      float(y + gh), float(t.left()),  float(t.bottom()),
+        };
+        for (float f : quad)
+            textVertices.append(f);
+        x += glyphAdvance * scale;
+    }
+
+    double radius = d * 0.2;
+    QPointF center = origin + QPointF(radius, d / 2);
+    QRectF ring(center - QPointF(radius, radius), center + QPointF(radius, radius));
+    QVector<float> ringVertices {
+        float(ring.left()),  float(ring.top()),    -1, -1,
+        float(ring.right()), float(ring.top()),     1, -1,
+        float(ring.left()),  float(ring.bottom()), -1,  1,
+        float(ring.right()), float(ring.top()),     1, -1,
+        float(ring.right()), float(ring.bottom()),  1,  1,
+        float(ring.left()),  float(ring.bottom()), -1,  1,
+    };
+
+    glViewport(0, 0, target.width(), target.height());
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    program->bind();
+    program->setUniformValue("target", QSizeF(target));
+    program->setUniformValue("fill", fillColor);
+    program->setUniformValue("back", backColor);
+
+    program->setUniformValue("mode", 1);
+    program->setUniformValue("factor", GLfloat(std::min(std::max(
+            msecLeft / double(msecDuration), 0.0), 1.0)));
+    program->setUniformValue("inner", GLfloat(0.6));
+    program->setUniformValue("pixel", GLfloat(1.5 / radius));
+    drawQuads(ringVertices);
+
+    program->setUniformValue("mode", 0);
+    program->setUniformValue("atlas", 0);
+    atlas->bind(0);
+    drawQuads(textVertices);
+    atlas->release(0);
+
+    program->release();
+    glDisable(GL_BLEND);
+}
+
+void CountdownOverlay::drawQuads(const QVector<float> &vertices)
+{
+    if (vertices.isEmpty())
+        return;
+    vertexBuffer.bind();
+    vertexBuffer.allocate(vertices.constData(), vertices.size() * int(sizeof(float)));
+    int position = program->attributeLocation("position");
+    int texCoord = program->attributeLocation("texCoord");
+    program->enableAttributeArray(position);
+    program->enableAttributeArray(texCoord);
+    program->setAttributeBuffer(position, GL_FLOAT, 0, 2, 4 * sizeof(float));
+    program->setAttributeBuffer(texCoord, GL_FLOAT, 2 * sizeof(float), 2,
+                                4 * sizeof(float));
+    glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 4);
+    program->disableAttributeArray(position);
+    program->disableAttributeArray(texCoord);
+    vertexBuffer.release();
+}
@@ -0,0 +1,60 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef COUNTDOWNOVERLAY_H
+#define COUNTDOWNOVERLAY_H
+
+#include <QOpenGLBuffer>
+#include <QOpenGLFunctions>
+#include <QRectF>
+#include <QScopedPointer>
+#include <QVector>
+
+class QOpenGLShaderProgram;
+class QOpenGLTexture;
+
+// Draws the countdown of DisplayWidget::paintCountdown with GL, on top of
+// whatever is already in the bound framebuffer.  The digits come from a
+// glyph atlas uploaded once and the ring is shaded analytically, so a
+// frame costs two draw calls and a few dozen vertices.  All methods must
+// be called with the owning context current.
+class CountdownOverlay : protected QOpenGLFunctions
+{
+public:
+    CountdownOverlay();
+    ~CountdownOverlay();
+
+    void paint(const QSize &target, qint64 msecLeft, qint64 msecDuration);
+    void release();
+
+private:
+    bool initialize();
+    void drawQuads(const QVector<float> &vertices);
+
+    static constexpr int glyphPixels = 128;
+    static const char glyphs[];
+
+    bool initialized = false;
+    bool failed = false;
+    QScopedPointer<QOpenGLShaderProgram> program;
+    QScopedPointer<QOpenGLTexture> atlas;
+    QOpenGLBuffer vertexBuffer;
+    QRectF glyphRects[11];
+    double glyphAdvance = 0;
+    double glyphHeight = 0;
+};
+
+#endif // COUNTDOWNOVERLAY_H
@@ -0,0 +1,193 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <algorithm>
+#include <QDebug>
+#include "cuelist.h"
+#include "displaywidget.h"
+#include "trace.h"
+
+CueList::CueList(DisplayWidget *first, DisplayWidget *second, QObject *parent)
+    : QObject(parent), mainOutput(first), spareOutput(second),
+      live(first), next(second)
+{
+    for (DisplayWidget *d : { first, second }) {
+        connect(d, &DisplayWidget::dismissed, this, [this,d]() {
+            if (isRunning() && d == live)
+                stop();
+        });
+    }
+}
+
+CueList::~CueList()
+{
+    decodeJob.cancel();
+}
+
+void CueList::setCues(const QList<Cue> &cues)
+{
+    this->cues = cues;
+    if (isRunning())
+        prepare(currentIndex + 1);
+}
+
+int CueList::current() const
+{
+    return currentIndex;
+}
+
+int CueList::standby() const
+{
+    return standbyLoaded ? standbyIndex : -1;
+}
+
+bool CueList::isRunning() const
+{
+    return currentIndex >= 0;
+}
+
+// The window that mirrors and frame sharing are attached to: the live
+// cue's, or the first window while the list is stopped.
+DisplayWidget *CueList::output() const
+{
+    return live;
+}
+
+void CueList::go()
+{
+    goTo(currentIndex + 1);
+}
+
+void CueList::back()
+{
+    goTo(std::max(currentIndex - 1, 0));
+}
+
+void CueList::goTo(int index)
+{
+    if (index < 0 || index >= cues.count())
+        return;
+    if (index != standbyIndex)
+        prepare(index);
+    goPending = true;
+    if (standbyLoaded)
+        takeStandby();
+    else if (cues[index].kind == Cue::StillCue)
+        decode(JobScheduler::OnAir);
+}
+
+// Before the first GO, loads the cue the operator is about to start with.
+void CueList::standBy(int index)
+{
+    if (!isRunning() && index != standbyIndex)
+        prepare(index);
+}
+
+// Fades out the live cue, if any, and drops the one in standby.  The first
+// window is left alone unless it holds a cue.
+void CueList::stop()
+{
+    bool running = isRunning();
+    decodeJob.cancel();
+    goPending = false;
+    currentIndex = -1;
+    standbyIndex = -1;
+    standbyLoaded = false;
+    if (running)
+        live->stop();
+    if (live == spareOutput) {
+        mainOutput->cut();
+        spareOutput->moveOutputsTo(mainOutput);
+    } else {
+        spareOutput->cut();
+    }
+    live = mainOutput;
+    next = spareOutput;
+}
+
+void CueList::imagePrepared(const QImage &frame)
+{
+    if (standbyIndex < 0)
+        return;
+    if (frame.isNull())
+        qWarning() << "cue list: could not decode" << cues[standbyIndex].filename;
+    next->standbyImage(frame);
+    standbyReadied();
+}
+
+// Stills are decoded off the GUI thread; videos are opened paused by mpv in
+// the standby window's own context, and countdowns need nothing but the
+// window.
+void CueList::prepare(int index)
+{
+    TRACE_SPAN("cue.prepare");
+    decodeJob.cancel();
+    standbyIndex = index;
+    standbyLoaded = false;
+    if (index < 0 || index >= cues.count()) {
+        standbyIndex = -1;
+        next->cut();
+        return;
+    }
+
+    const Cue &cue = cues[index];
+    switch (cue.kind) {
+    case Cue::CountdownCue:
+        next->standbyCountdown(cue.msecDuration);
+        standbyReadied();
+        break;
+    case Cue::VideoCue:
+        next->standbyMedia(cue.filename, cue.msecIn, cue.msecOut);
+        standbyReadied();
+        break;
+    case Cue::StillCue:
+        decode(JobScheduler::NextUp);
+        break;
+    }
+}
+
+// Asking again at a higher priority joins the decode already queued.
+void CueList::decode(JobScheduler::Priority priority)
+{
+    JobScheduler::Handle previous = decodeJob;
+    decodeJob = DisplayWidget::prepareImageJob(priority, cues[standbyIndex].filename,
+                                               next->outputSize(), this,
+                                               [this](const QImage &frame) {
+        imagePrepared(frame);
+    });
+    previous.cancel();
+}
+
+void CueList::standbyReadied()
+{
+    standbyLoaded = true;
+    emit standbyReady(standbyIndex);
+    if (goPending)
+        takeStandby();
+}
+
+void CueList::takeStandby()
+{
+    TRACE_SPAN("cue.go");
+    goPending = false;
+    next->take();
+    live->moveOutputsTo(next);
+    live->cut();
+    std::swap(live, next);
+    currentIndex = standbyIndex;
+    emit cueStarted(currentIndex);
+    prepare(currentIndex + 1);
+}
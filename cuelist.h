@@ -0,0 +1,77 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef CUELIST_H
+#define CUELIST_H
+
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include "common.h"
+#include "jobscheduler.h"
+
+class DisplayWidget;
+
+// Runs a fixed order of cues on two output windows.  One shows the live
+// cue while the other holds the next cue in standby (see
+// DisplayWidget::take), so that GO is a cut rather than a load.  As soon
+// as a cue goes live, the window it replaced starts on the following one.
+// Mirrors and frame sharing move with the live cue, and go back to the
+// first window when the list stops.
+class CueList : public QObject
+{
+    Q_OBJECT
+public:
+    CueList(DisplayWidget *first, DisplayWidget *second, QObject *parent = nullptr);
+    ~CueList();
+
+    void setCues(const QList<Cue> &cues);
+    int current() const;
+    int standby() const;
+    bool isRunning() const;
+    DisplayWidget *output() const;
+
+signals:
+    void cueStarted(int index);
+    void standbyReady(int index);
+
+public slots:
+    void go();
+    void back();
+    void goTo(int index);
+    void standBy(int index);
+    void stop();
+
+private:
+    void prepare(int index);
+    void decode(JobScheduler::Priority priority);
+    void imagePrepared(const QImage &frame);
+    void standbyReadied();
+    void takeStandby();
+
+    DisplayWidget *mainOutput;
+    DisplayWidget *spareOutput;
+    DisplayWidget *live;
+    DisplayWidget *next;
+    QList<Cue> cues;
+    int currentIndex = -1;
+    int standbyIndex = -1;
+    bool standbyLoaded = false;
+    bool goPending = false;
+    JobScheduler::Handle decodeJob;
+};
+
+#endif // CUELIST_H
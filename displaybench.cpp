@@ -0,0 +1,231 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Headless benchmark of the DisplayWidget paint paths.  Build with
+//     qmake CONFIG+=benchmark && make
+// and run presenter-bench; it defaults to the offscreen platform and
+// prints one JSON document with per-frame time percentiles and heap
+// allocation counts for every case in the sweep.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QSysInfo>
+#include <QTextStream>
+#include "displaywidget.h"
+
+static std::atomic<quint64> allocCount { 0 };
+static std::atomic<quint64> allocBytes { 0 };
+
+void *operator new(std::size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    allocBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+struct Format {
+    const char *name;
+    QImage::Format format;
+};
+
+static const QList<QSize> outputSizes {
+    { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 }
+};
+static const QList<QSize> imageSizes {
+    { 1024, 768 }, { 4032, 3024 }, { 8192, 4608 }
+};
+static const QList<Format> imageFormats {
+    { "argb32pm", QImage::Format_ARGB32_Premultiplied },
+    { "argb32", QImage::Format_ARGB32 },
+    { "rgb32", QImage::Format_RGB32 },
+    { "rgb888", QImage::Format_RGB888 },
+};
+
+// A gradient with some detail so that scaling is not trivially cheap.
+static QImage sourceImage(const QSize &size, QImage::Format format)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    QPainter p(&image);
+    QLinearGradient g(0, 0, size.width(), size.height());
+    g.setColorAt(0, QColor(0x20,0x40,0x80));
+    g.setColorAt(1, QColor(0xe0,0xc0,0x40));
+    p.fillRect(image.rect(), g);
+    p.setPen(Qt::white);
+    for (int x = 0; x < size.width(); x += 64)
+        p.drawLine(x, 0, size.width() - x, size.height());
+    p.end();
+    return image.convertToFormat(format);
+}
+
+class Bench
+{
+public:
+    explicit Bench(int frames) : frames(frames) { }
+
+    template <typename Paint>
+    void run(const QString &name, const QSize &output, QJsonObject params,
+             Paint paint)
+    {
+        QImage target(output, QImage::Format_ARGB32_Premultiplied);
+        QList<qint64> times;
+        paint(target, 0);   // warm up caches and lazily built state
+        quint64 allocs = allocCount;
+        quint64 bytes = allocBytes;
+        for (int i = 0; i < frames; i++) {
+            QElapsedTimer t;
+            t.start();
+            paint(target, i);
+            times.append(t.nsecsElapsed());
+        }
+        allocs = allocCount - allocs;
+        bytes = allocBytes - bytes;
+        std::sort(times.begin(), times.end());
+
+        params["case"] = name;
+        params["outputWidth"] = output.width();
+        params["outputHeight"] = output.height();
+        params["frames"] = frames;
+        params["p50Usec"] = percentile(times, 0.50);
+        params["p90Usec"] = percentile(times, 0.90);
+        params["p99Usec"] = percentile(times, 0.99);
+        params["maxUsec"] = times.last() / 1000.0;
+        params["allocsPerFrame"] = double(allocs) / frames;
+        params["allocBytesPerFrame"] = double(bytes) / frames;
+        results.append(params);
+        QTextStream(stderr) << name << " " << output.width() << "x"
+                            << output.height() << " p50 "
+                            << params["p50Usec"].toDouble() << "us\n";
+    }
+
+    QJsonArray results;
+
+private:
+    static double percentile(const QList<qint64> &sorted, double q)
+    {
+        int i = std::min(int(q * sorted.count()), sorted.count() - 1);
+        return sorted[i] / 1000.0;
+    }
+
+    int frames;
+};
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Presenter paint path benchmark");
+    parser.addHelpOption();
+    QCommandLineOption framesOption("frames", "Frames per case.", "n", "60");
+    QCommandLineOption outputOption("output", "Write JSON to a file.", "file");
+    parser.addOption(framesOption);
+    parser.addOption(outputOption);
+    parser.process(a);
+
+    Bench bench(std::max(parser.value(framesOption).toInt(), 1));
+    for (const QSize &output : outputSizes) {
+        QRect area(QPoint(0,0), output);
+
+        bench.run("countdown", output, {}, [&](QImage &target, int i) {
+            QPainter p(&target);
+            DisplayWidget::paintCountdown(p, area, 300000 - i * 50, 300000);
+        });
+
+        for (const QSize &imageSize : imageSizes) {
+            for (const Format &f : imageFormats) {
+                QJsonObject params {
+                    { "imageWidth", imageSize.width() },
+                    { "imageHeight", imageSize.height() },
+                    { "format", f.name }
+                };
+                QImage source = sourceImage(imageSize, f.format);
+                QSize fit = imageSize.scaled(output, Qt::KeepAspectRatio);
+                QImage prepared = source.scaled(fit, Qt::IgnoreAspectRatio,
+                                                Qt::SmoothTransformation)
+                        .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+                // Scaled at paint time, as for images shown with displayFile.
+                bench.run("image", output, params, [&](QImage &target, int) {
+                    QPainter p(&target);
+                    DisplayWidget::paintImage(p, area, source);
+                });
+                // Pre-scaled, as for slideshows and bundles.
+                bench.run("imagePrepared", output, params, [&](QImage &target, int) {
+                    QPainter p(&target);
+                    DisplayWidget::paintImage(p, area, prepared);
+                });
+                bench.run("crossfade", output, params, [&](QImage &target, int i) {
+                    QPainter p(&target);
+                    DisplayWidget::paintImage(p, area, prepared, source,
+                                              (i % 12) / 12.0);
+                });
+                // Window fades are done by the compositor; this is the
+                // equivalent cost when blending in software.
+                bench.run("fade", output, params, [&](QImage &target, int i) {
+                    QPainter p(&target);
+                    DisplayWidget::paintNothing(p, area);
+                    p.setOpacity((i % 12) / 12.0);
+                    DisplayWidget::paintImage(p, area, prepared);
+                });
+            }
+        }
+    }
+
+    QJsonObject report {
+        { "qtVersion", qVersion() },
+        { "cpu", QSysInfo::currentCpuArchitecture() },
+        { "os", QSysInfo::prettyProductName() },
+        { "platform", QGuiApplication::platformName() },
+        { "results", bench.results }
+    };
+    QByteArray json = QJsonDocument(report).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile f(parser.value(outputOption));
+        if (!f.open(QIODevice::WriteOnly)) {
+            QTextStream(stderr) << f.errorString() << "\n";
+            return 1;
+        }
+        f.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
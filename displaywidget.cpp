@@ -14,6 +14,7 @@
  * with Presenter; if not, write to the Free Software Foundation, Inc.,
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
+#include <cstring>
 #include <QCoreApplication>
 #include <QFileInfo>
 #include <QHBoxLayout>
@@ -21,11 +22,20 @@
 #include <QPaintEvent>
 #include <QStyle>
 #include <QTime>
+#include <QUrl>
+#include <QWindow>
 #include "displaywidget.h"
+#include "frameexport.h"
+#include "trace.h"
+#include "videomirror.h"
 #include "videowidget.h"
 
-constexpr qint64 fadeTimeMsec = 300;
-constexpr qint64 updateMsec = 1000/20;
+static QRect fitRect(const QSize &imageSize, const QRect &area)
+{
+    QSize picSize = imageSize.scaled(area.size(), Qt::KeepAspectRatio);
+    return QStyle::alignedRect(Qt::LayoutDirectionAuto, Qt::AlignCenter,
+                               picSize, area);
+}
 
 DisplayWidget::DisplayWidget(QWidget *parent, bool widgetMode) : QWidget(parent), widgetMode(widgetMode)
 {
@@ -42,21 +52,26 @@ DisplayWidget::DisplayWidget(QWidget *parent, bool widgetMode) : QWidget(parent)
             this, &DisplayWidget::timer_timeout);
     connect(&fadeTimer, &QTimer::timeout,
             this, &DisplayWidget::fadeTimer_timeout);
-
-    videoWidget = new VideoWidget;
-    videoWidget->setSilentMode(widgetMode);
-    videoWidget->setEarlyStopMode(widgetMode);
-    connect(videoWidget, &VideoWidget::eofReached,
-            this, &DisplayWidget::stop);
+    transitionTimer.setInterval(updateMsec);
+    transitionTimer.setSingleShot(false);
+    connect(&transitionTimer, &QTimer::timeout,
+            this, &DisplayWidget::transitionTimer_timeout);
+    connect(MemoryBudget::instance(), &MemoryBudget::pressure,
+            this, &DisplayWidget::releaseMemory);
 
     auto *layout = new QHBoxLayout;
     layout->setMargin(0);
-    layout->addWidget(videoWidget);
     setLayout(layout);
+    textOverlay = new TextOverlay(this);
 }
 
 DisplayWidget::~DisplayWidget()
 {
+    if (source)
+        source->removeMirror(this);
+    for (DisplayWidget *m : mirrors)
+        m->source = nullptr;
+    delete videoMirror;
     delete videoWidget;
 }
 
@@ -67,32 +82,81 @@ void DisplayWidget::startCountdown(int msecDuration)
 
 void DisplayWidget::startCountdownPartway(int msecPosition, int msecDuration)
 {
-    videoWidget->stop();
-    videoWidget->hide();
-    displayMode = DisplayingCountdown;
     QDateTime nowTime = QDateTime::currentDateTime();
+    if (zoneLayout.hasCountdown()) {
+        // The countdown goes to its zone, and the main zone keeps playing.
+        setZoneCountdown(nowTime.addMSecs(msecDuration - msecPosition), msecDuration);
+        framePending = true;
+        emit contentReady();
+        emit countdownStarted(zoneCountdownEnd);
+        startFader(FadingIn);
+        if (!widgetMode)
+            show();
+        return;
+    }
+    displayMode = DisplayingCountdown;
     endTime = nowTime.addMSecs(msecDuration - msecPosition);
     this->msecDuration = msecDuration;
     msecLeft = msecDuration - msecPosition;
+    if (countdownBackground.isEmpty()) {
+        stopVideo();
+    } else {
+        // The video widget draws the countdown itself, in the same pass as
+        // the video frame.
+        prepareVideo();
+        videoWidget->show();
+        videoWidget->play(countdownBackground, true);
+        videoWidget->setCountdownOverlay(endTime, msecDuration);
+    }
     timer.start();
+    framePending = true;
+    emit contentReady();
+    emit countdownStarted(endTime);
 
     startFader(FadingIn);
     if (!widgetMode)
         show();
 }
 
+// Countdowns loop this video behind them; an empty filename draws them on
+// black.
+void DisplayWidget::setCountdownBackground(const QString &filename)
+{
+    countdownBackground = filename;
+}
+
 void DisplayWidget::displayFile(const QString &filename)
 {
-    QStringList videoExtensions { "mp4", "mkv", "avi", "m4v" };
-    QString ext = QFileInfo(filename).suffix();
-    if (videoExtensions.contains(ext)) {
+    TRACE_SPAN("displayFile");
+    if (displayMode == DisplayingCountdown)
+        stopVideo();
+    previousImage = QImage();
+    transitionTimer.stop();
+    framePending = true;
+    bool stream = isStreamUrl(filename);
+    if (isMediaFile(filename)) {
+        prepareVideo();
         videoWidget->show();
-        videoWidget->play(filename);
+        if (stream)
+            videoWidget->playStream(filename);
+        else
+            videoWidget->play(filename);
         displayMode = DisplayingMedia;
     } else {
-        bool success = image.load(filename);
+        bool success;
+        {
+            TRACE_SPAN("image.load");
+            success = image.load(filename);
+        }
         displayMode = success ? DisplayingImage : DisplayingNothing;
-        videoWidget->hide();
+        if (videoWidget)
+            videoWidget->hide();
+        emit contentReady();
+    }
+    accountImages();
+    if (stream && !widgetMode && fadeMode == FadedOut) {
+        awaitStream();
+        return;
     }
     startFader(FadingIn);
     update();
@@ -100,9 +164,497 @@ void DisplayWidget::displayFile(const QString &filename)
         show();
 }
 
+void DisplayWidget::displayImage(const QImage &prepared, bool crossfade)
+{
+    // Only crossfade between two stills; anything else fades the window.
+    bool showingImage = displayMode == DisplayingImage
+            && fadeMode != FadedOut && fadeMode != FadingOut;
+    if (crossfade && showingImage && !image.isNull()) {
+        previousImage = image;
+        transitionFactor = 0.0;
+        transitionClock.start();
+        transitionFrameClock.start();
+        transitionTimer.start();
+    } else {
+        previousImage = QImage();
+        transitionFactor = 1.0;
+        transitionTimer.stop();
+    }
+    if (displayMode == DisplayingMedia || displayMode == DisplayingCountdown)
+        stopVideo();
+    else if (videoWidget)
+        videoWidget->hide();
+    image = prepared;
+    displayMode = DisplayingImage;
+    accountImages();
+    framePending = true;
+    emit contentReady();
+    startFader(FadingIn);
+    update();
+    if (!widgetMode)
+        show();
+}
+
+int DisplayWidget::lateFrames() const
+{
+    return lateFrameCount;
+}
+
+// mpv is only started once media is about to be shown, so sessions that
+// never play video do not pay for it.  Call this ahead of time to take the
+// startup cost off the first play.
+void DisplayWidget::prepareVideo()
+{
+    if (videoWidget)
+        return;
+    TRACE_SPAN("prepareVideo");
+    videoWidget = new VideoWidget;
+    videoWidget->setSilentMode(widgetMode);
+    videoWidget->setEarlyStopMode(widgetMode);
+    videoWidget->hide();
+    videoWidget->setMirrored(!mirrors.isEmpty());
+    videoWidget->setFrameSink(videoFrameSink());
+    videoWidget->setStreamCache(streamCache);
+    videoWidget->installEventFilter(this);
+    connect(videoWidget, &VideoWidget::eofReached,
+            this, &DisplayWidget::stop);
+    connect(videoWidget, &VideoWidget::fileLoaded,
+            this, &DisplayWidget::contentReady);
+    connect(videoWidget, &VideoWidget::frameRendered, this, [this]() {
+        if (framePending) {
+            framePending = false;
+            emit framePainted();
+        }
+    });
+    connect(videoWidget, &VideoWidget::streamReady, this, [this]() {
+        if (streamPending && displayMode == DisplayingMedia) {
+            startFader(FadingIn);
+            raise();
+        }
+    });
+    connect(videoWidget, &VideoWidget::streamFailed,
+            this, &DisplayWidget::stop);
+    connect(videoWidget, &VideoWidget::streamStatsChanged,
+            this, &DisplayWidget::streamStatsChanged);
+    layout()->addWidget(videoWidget);
+    placeZones();
+    raiseOverlays();
+}
+
+// Standby content is loaded into the window while it is mapped but fully
+// transparent and ignoring input, so that GL and mpv are ready and take()
+// can cut to it within a frame.
+void DisplayWidget::standbyCountdown(int msecDuration)
+{
+    stopVideo();
+    displayMode = DisplayingCountdown;
+    this->msecDuration = msecDuration;
+    msecLeft = msecDuration;
+    enterStandby();
+}
+
+void DisplayWidget::standbyImage(const QImage &prepared)
+{
+    stopVideo();
+    image = prepared;
+    displayMode = DisplayingImage;
+    enterStandby();
+}
+
+void DisplayWidget::standbyMedia(const QString &filename, int msecIn, int msecOut)
+{
+    prepareVideo();
+    videoWidget->show();
+    videoWidget->clearOverlay();
+    videoWidget->cue(filename, msecIn, msecOut);
+    displayMode = DisplayingMedia;
+    enterStandby();
+}
+
+bool DisplayWidget::isStandingBy() const
+{
+    return standingBy;
+}
+
+// Whether stop() has anything to fade out.
+bool DisplayWidget::isShown() const
+{
+    return fadeMode != FadedOut && !standingBy;
+}
+
+// The end of the countdown on air, if one is.
+QDateTime DisplayWidget::countdownEnd() const
+{
+    if (zoneCountdownEnd.isValid())
+        return zoneCountdownEnd;
+    if (displayMode == DisplayingCountdown && !standingBy && fadeMode != FadingOut)
+        return endTime;
+    return QDateTime();
+}
+
+void DisplayWidget::take()
+{
+    if (!standingBy)
+        return;
+    TRACE_SPAN("take");
+    standingBy = false;
+    framePending = true;
+    if (displayMode == DisplayingCountdown) {
+        endTime = QDateTime::currentDateTime().addMSecs(msecDuration);
+        timer.start();
+        emit countdownStarted(endTime);
+    } else if (displayMode == DisplayingMedia) {
+        videoWidget->resume();
+    }
+    fadeMode = FadedIn;
+    fadeFactor = 1.0;
+    if (!widgetMode) {
+        windowHandle()->setFlag(Qt::WindowTransparentForInput, false);
+        setOpacity(1.0);
+        raise();
+    }
+    update();
+    emit contentReady();
+}
+
+// Hide at once, without a fade.
+void DisplayWidget::cut()
+{
+    bool shown = fadeMode != FadedOut && !standingBy;
+    if (streamPending || standingBy) {
+        standingBy = false;
+        streamPending = false;
+        if (!widgetMode)
+            windowHandle()->setFlag(Qt::WindowTransparentForInput, false);
+    }
+    timer.stop();
+    fadeTimer.stop();
+    transitionTimer.stop();
+    stopVideo();
+    displayMode = DisplayingNothing;
+    fadeMode = FadedOut;
+    image = QImage();
+    previousImage = QImage();
+    accountImages();
+    setZoneCountdown(QDateTime(), 0);
+    hide();
+    if (shown)
+        emit fadedOut();
+}
+
+void DisplayWidget::enterStandby()
+{
+    standingBy = true;
+    timer.stop();
+    fadeTimer.stop();
+    transitionTimer.stop();
+    previousImage = QImage();
+    transitionFactor = 1.0;
+    fadeMode = FadedOut;
+    framePending = false;
+    accountImages();
+    if (!widgetMode) {
+        setOpacity(0.0);
+        show();
+        windowHandle()->setFlag(Qt::WindowTransparentForInput, true);
+        lower();
+    }
+    update();
+}
+
+// A stream is opened in the mapped but transparent window, as for standby,
+// and faded in once it has pre-buffered.
+void DisplayWidget::awaitStream()
+{
+    streamPending = true;
+    setOpacity(0.0);
+    show();
+    windowHandle()->setFlag(Qt::WindowTransparentForInput, true);
+    lower();
+}
+
+void DisplayWidget::stopVideo()
+{
+    if (!videoWidget)
+        return;
+    videoWidget->clearOverlay();
+    videoWidget->stop();
+    videoWidget->hide();
+}
+
+// Mirrors are further output windows that show whatever this one shows.
+// They paint from this widget's decoded images and draw its video texture,
+// so each costs a present and not another decode.  Mirrors ignore input.
+void DisplayWidget::addMirror(DisplayWidget *mirror)
+{
+    if (mirror->source || mirrors.contains(mirror))
+        return;
+    mirror->source = this;
+    mirrors.append(mirror);
+    mirror->textOverlay->setSource(textOverlay);
+    mirror->setZoneLayout(zoneLayout);
+    if (videoWidget)
+        videoWidget->setMirrored(true);
+    syncMirrors();
+}
+
+void DisplayWidget::removeMirror(DisplayWidget *mirror)
+{
+    if (!mirrors.removeOne(mirror))
+        return;
+    mirror->source = nullptr;
+    mirror->textOverlay->setSource(nullptr);
+    mirror->setZoneLayout(ZoneLayout());
+    mirror->showVideoMirror(false);
+    mirror->hide();
+    if (videoWidget && mirrors.isEmpty())
+        videoWidget->setMirrored(false);
+}
+
+// Mirrors and frame sharing follow whichever output is live, e.g. when a
+// cue is taken on the standby output.
+void DisplayWidget::moveOutputsTo(DisplayWidget *other)
+{
+    if (other == this)
+        return;
+    const QList<DisplayWidget*> moved = mirrors;
+    for (DisplayWidget *m : moved) {
+        removeMirror(m);
+        other->addMirror(m);
+    }
+    if (frameExport) {
+        other->setFrameExport(frameExport);
+        setFrameExport(nullptr);
+    }
+}
+
+// Tiled outputs each show their part of one larger canvas, e.g. for a
+// video wall.  The tile is in canvas coordinates; an empty canvas shows
+// everything in the window again.
+void DisplayWidget::setTile(const QSize &canvas, const QRect &tile)
+{
+    this->canvas = canvas;
+    this->tile = tile;
+    textOverlay->setTile(canvas, tile);
+    placeZones();
+    update();
+}
+
+// Mirrors take the same layout, sharing its stills.
+void DisplayWidget::setZoneLayout(const ZoneLayout &layout)
+{
+    zoneLayout = layout;
+    zoneCountdownEnd = QDateTime();
+    qDeleteAll(zones);
+    zones.clear();
+    for (const ZoneLayout::Zone &z : layout.zones) {
+        auto *zone = new OutputZone(z, this);
+        connect(zone, &OutputZone::framePainted, this, [this]() {
+            if (framePending) {
+                framePending = false;
+                emit framePainted();
+            }
+        });
+        connect(zone, &OutputZone::repainted, this, [this,zone]() {
+            queueExport(zone->geometry());
+        });
+        connect(zone, &OutputZone::countdownFinished, this, [this]() {
+            setZoneCountdown(QDateTime(), 0);
+            if (!source && displayMode == DisplayingNothing)
+                stop();
+        });
+        zones.append(zone);
+        zone->show();
+    }
+    placeZones();
+    raiseOverlays();
+    update();
+    for (DisplayWidget *m : mirrors)
+        m->setZoneLayout(layout);
+}
+
+// Stills arrive once decoded for the output's size, so that a running zone
+// countdown carries on across a resize.
+void DisplayWidget::setZoneImage(int index, const QImage &image)
+{
+    if (index < 0 || index >= zones.count())
+        return;
+    zoneLayout.zones[index].image = image;
+    zones[index]->setImage(image);
+    for (DisplayWidget *m : mirrors)
+        m->setZoneImage(index, image);
+}
+
+// The size that content should be prepared at.
+QSize DisplayWidget::outputSize() const
+{
+    return canvas.isEmpty() ? size() : canvas;
+}
+
+// The size that the main zone's content should be prepared at.
+QSize DisplayWidget::contentSize() const
+{
+    return mainArea().size();
+}
+
+QRect DisplayWidget::outputArea() const
+{
+    return canvas.isEmpty() ? rect() : QRect(-tile.topLeft(), canvas);
+}
+
+QRect DisplayWidget::mainArea() const
+{
+    return ZoneLayout::map(zoneLayout.main, outputArea());
+}
+
+// Video fills the visible part of the main zone; when that is not all of
+// it, the video widget renders the whole zone and shows its part, as for
+// tiles.
+void DisplayWidget::placeZones()
+{
+    QRect main = mainArea();
+    QRect visible = main & rect();
+    if (visible.isEmpty())
+        visible = QRect();
+    layout()->setContentsMargins(visible.left(), visible.top(),
+                                 width() - visible.left() - visible.width(),
+                                 height() - visible.top() - visible.height());
+    QSize videoCanvas;
+    QRect videoTile;
+    if (visible != main) {
+        videoCanvas = main.size();
+        videoTile = visible.translated(-main.topLeft());
+    }
+    if (videoWidget)
+        videoWidget->setTile(videoCanvas, videoTile);
+    if (videoMirror)
+        videoMirror->setTile(videoCanvas, videoTile);
+    for (OutputZone *zone : zones)
+        zone->place(outputArea());
+}
+
+void DisplayWidget::raiseOverlays()
+{
+    for (OutputZone *zone : zones)
+        zone->raise();
+    textOverlay->raise();
+}
+
+// Main zone content repaints leave the other zones alone.
+void DisplayWidget::updateMain()
+{
+    update(mainArea() & rect());
+}
+
+void DisplayWidget::setZoneCountdown(const QDateTime &endTime, qint64 msecDuration)
+{
+    zoneCountdownEnd = msecDuration > 0 && zoneLayout.hasCountdown() ? endTime : QDateTime();
+    for (OutputZone *zone : zones)
+        if (zone->isCountdown())
+            zone->setCountdown(endTime, msecDuration);
+    for (DisplayWidget *m : mirrors)
+        m->setZoneCountdown(endTime, msecDuration);
+}
+
+void DisplayWidget::setVisible(bool visible)
+{
+    QWidget::setVisible(visible);
+    for (DisplayWidget *m : mirrors)
+        m->setVisible(visible);
+}
+
+void DisplayWidget::setOpacity(qreal opacity)
+{
+    setWindowOpacity(opacity);
+    queueExport(outputArea());
+    for (DisplayWidget *m : mirrors)
+        m->setWindowOpacity(opacity);
+}
+
+void DisplayWidget::syncMirrors()
+{
+    bool video = videoWidget && !videoWidget->isHidden();
+    for (DisplayWidget *m : mirrors) {
+        m->setWindowOpacity(windowOpacity());
+        m->setVisible(isVisible());
+        m->showVideoMirror(video);
+        m->update();
+    }
+}
+
+void DisplayWidget::showVideoMirror(bool show)
+{
+    if (!show) {
+        if (videoMirror)
+            videoMirror->hide();
+        return;
+    }
+    if (!videoMirror) {
+        videoMirror = new VideoMirror;
+        layout()->addWidget(videoMirror);
+        placeZones();
+        raiseOverlays();
+    }
+    videoMirror->setSource(source ? source->videoWidget : nullptr);
+    videoMirror->show();
+}
+
+bool DisplayWidget::isMediaFile(const QString &filename)
+{
+    static const QStringList videoExtensions { "mp4", "mkv", "avi", "m4v" };
+    return isStreamUrl(filename)
+            || videoExtensions.contains(QFileInfo(filename).suffix());
+}
+
+bool DisplayWidget::isStreamUrl(const QString &filename)
+{
+    static const QStringList streamSchemes {
+        "http", "https", "rtmp", "rtsp", "rtp", "srt", "udp"
+    };
+    return streamSchemes.contains(QUrl(filename).scheme().toLower());
+}
+
+// Decode and scale an image to fit the given size, in a format that
+// QPainter can blit without conversion.  Safe to call from any thread.
+QImage DisplayWidget::prepareImage(const QString &filename, const QSize &size,
+                                  const JobScheduler::Job *job)
+{
+    TRACE_SPAN("prepareImage");
+    QImage decoded;
+    if (!decoded.load(filename))
+        return QImage();
+    // Nobody wants it any more; skip the scaling.
+    if (job && job->isCancelled())
+        return QImage();
+    if (!size.isEmpty()) {
+        QSize fit = decoded.size().scaled(size, Qt::KeepAspectRatio);
+        if (fit != decoded.size())
+            decoded = decoded.scaled(fit, Qt::IgnoreAspectRatio,
+                                     Qt::SmoothTransformation);
+    }
+    return decoded.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+}
+
+// Requests for the same file at the same size share one decode.
+JobScheduler::Handle DisplayWidget::prepareImageJob(JobScheduler::Priority priority,
+                                                   const QString &filename, const QSize &size,
+                                                   QObject *context,
+                                                   const std::function<void(const QImage &)> &done)
+{
+    QString key = QString("image %1x%2 %3").arg(size.width()).arg(size.height()).arg(filename);
+    return JobScheduler::instance()->compute<QImage>(priority, key,
+            [filename, size](const JobScheduler::Job &job) {
+        return prepareImage(filename, size, &job);
+    }, context, done);
+}
+
 void DisplayWidget::stop()
 {
-    startFader(FadingOut);
+    // A stream still pre-buffering has nothing on screen to fade.
+    if (streamPending)
+        cut();
+    else
+        startFader(FadingOut);
 }
 
 void DisplayWidget::timer_timeout()
@@ -114,7 +666,10 @@ void DisplayWidget::timer_timeout()
 
     QDateTime nowTime = QDateTime::currentDateTime();
     msecLeft = nowTime.msecsTo(endTime);
-    update();
+    if (videoWidget && videoWidget->hasOverlay())
+        videoWidget->update();
+    else
+        updateMain();
 
     if (msecLeft < 0 && !fadeTimer.isActive()) {
         startFader(FadingOut);
@@ -123,12 +678,14 @@ void DisplayWidget::timer_timeout()
 
 void DisplayWidget::fadeTimer_timeout()
 {
+    TRACE_SPAN("fadeTimer_timeout");
     if (widgetMode)
         return;
 
     if (fadeMode == FadedIn || fadeMode == FadedOut)
         return;
 
+    countFrame(fadeFrameClock);
     QDateTime nowTime = QDateTime::currentDateTime();
     qint64 msecs = fadeStart.msecsTo(nowTime);
     qreal factor = msecs/double(fadeTimeMsec);
@@ -138,87 +695,351 @@ void DisplayWidget::fadeTimer_timeout()
     else
         fadeFactor = factor;
 
-    setWindowOpacity(fadeMode == FadingIn ? factor : 1.0 - factor);
-    update();
+    setOpacity(fadeMode == FadingIn ? factor : 1.0 - factor);
+    updateMain();
 
     if (fadeFactor >= 1.0) {
         if (fadeMode == FadingOut) {
-            if (displayMode == DisplayingMedia) {
-                videoWidget->stop();
-                videoWidget->hide();
-            }
+            if (displayMode == DisplayingMedia || displayMode == DisplayingCountdown)
+                stopVideo();
             displayMode = DisplayingNothing;
             fadeMode = FadedOut;
+            image = QImage();
+            previousImage = QImage();
+            accountImages();
             timer.stop();
+            setZoneCountdown(QDateTime(), 0);
             hide();
+            emit fadedOut();
         } else {
             fadeMode = FadedIn;
+            emit fadedIn();
         }
         fadeTimer.stop();
     }
 }
 
+void DisplayWidget::transitionTimer_timeout()
+{
+    countFrame(transitionFrameClock);
+    transitionFactor = std::min(1.0, transitionClock.elapsed()
+                                     / double(transitionTimeMsec));
+    if (transitionFactor >= 1.0) {
+        previousImage = QImage();
+        accountImages();
+        transitionTimer.stop();
+    }
+    updateMain();
+}
+
+// Drop what is not on screen, and shrink stills that were decoded larger
+// than they are shown, e.g. by displayFile or in the preview.
+void DisplayWidget::releaseMemory()
+{
+    if (!transitionTimer.isActive())
+        previousImage = QImage();
+    if (displayMode != DisplayingImage) {
+        image = QImage();
+    } else if (!image.isNull() && !rect().isEmpty()) {
+        QSize shown = fitRect(image.size(), mainArea()).size() * devicePixelRatioF();
+        if (image.width() > shown.width() && !shown.isEmpty()) {
+            TRACE_SPAN("image.shrink");
+            image = image.scaled(shown, Qt::IgnoreAspectRatio,
+                                 Qt::SmoothTransformation)
+                    .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+            update();
+        }
+    }
+    accountImages();
+}
+
+void DisplayWidget::accountImages()
+{
+    imageMemory.set(image.sizeInBytes() + previousImage.sizeInBytes());
+}
+
 void DisplayWidget::paintEvent(QPaintEvent *e)
 {
-    Q_UNUSED(e);
-    switch (displayMode) {
-    case DisplayingNothing:
-        paintNothing();
+    // Other partial repaints are under text overlay blocks, which update
+    // their mirrors themselves.
+    QRect main = mainArea();
+    if (e->rect().contains(main & rect())) {
+        for (DisplayWidget *m : mirrors)
+            m->updateMain();
+    }
+    bool video = isVideoShown();
+    if (video && main.contains(rect()))
+        return;
+    QPainter p(this);
+    if (!main.contains(rect()))
+        paintNothing(p, rect());
+    if (video)
+        return;
+    paintShown(p, main);
+    queueExport(e->rect().contains(main & rect()) ? outputArea() : e->rect());
+    if (framePending) {
+        framePending = false;
+        emit framePainted();
+    }
+}
+
+void DisplayWidget::paintShown(QPainter &p, const QRect &area)
+{
+    const DisplayWidget &shown = source ? *source : *this;
+    switch (shown.displayMode) {
+    case DisplayingNothing: {
+        TRACE_SPAN("paint.nothing");
+        paintNothing(p, area);
         break;
-    case DisplayingCountdown:
-        paintCountdown();
+    }
+    case DisplayingCountdown: {
+        TRACE_SPAN("paint.countdown");
+        paintCountdown(p, area, shown.msecLeft, shown.msecDuration);
         break;
-    case DisplayingImage:
-        paintImage();
+    }
+    case DisplayingImage: {
+        TRACE_SPAN("paint.image");
+        paintImage(p, area, shown.image, shown.previousImage,
+                   shown.transitionFactor);
         break;
+    }
     case DisplayingMedia:
         break;
     }
 }
 
+// The whole canvas is painted again straight into the shared-memory slot,
+// faded as the window is, since the window's own pixels are the
+// compositor's.
+bool DisplayWidget::isVideoShown() const
+{
+    const DisplayWidget &shown = source ? *source : *this;
+    return shown.displayMode == DisplayingMedia
+            || (shown.videoWidget && shown.videoWidget->hasOverlay());
+}
+
+// Repaints are collected until the event loop is next idle and exported
+// as one frame.  The rectangle is in this widget; a tile only sees its
+// part of the canvas, so tiles repaint the whole canvas.
+void DisplayWidget::queueExport(const QRect &dirty)
+{
+    if (!frameExport)
+        return;
+    exportDirty += canvas.isEmpty() ? dirty : outputArea();
+    if (exportQueued)
+        return;
+    exportQueued = true;
+    QTimer::singleShot(0, this, [this]() {
+        exportQueued = false;
+        exportFrame();
+    });
+}
+
+// The frame is kept between exports and only its dirty part repainted,
+// so that a clock tick or an overlay fade step costs the area it changes
+// and a copy into the ring, rather than a full repaint.
+void DisplayWidget::exportFrame()
+{
+    if (!frameExport || exportDirty.isEmpty())
+        return;
+    QRect area(QPoint(), outputSize());
+    QRegion dirty = exportDirty.translated(-outputArea().topLeft());
+    exportDirty = QRegion();
+    qreal scale = devicePixelRatioF();
+    QSize size = area.size() * scale;
+    if (exportCanvas.size() != size) {
+        exportCanvas = QImage(size, QImage::Format_ARGB32_Premultiplied);
+        exportCanvas.setDevicePixelRatio(scale);
+        exportMemory.set(exportCanvas.sizeInBytes());
+        dirty = area;
+    }
+    // Video frames are exported by the video widget; the canvas is then
+    // out of date when stills come back.
+    if (isVideoShown()) {
+        exportDirty = outputArea();
+        return;
+    }
+
+    TRACE_SPAN("export.paint");
+    QPainter p(&exportCanvas);
+    p.setClipRegion(dirty);
+    paintNothing(p, area);
+    p.setOpacity(windowOpacity());
+    paintShown(p, ZoneLayout::map(zoneLayout.main, area));
+    for (OutputZone *zone : zones)
+        zone->paintZone(p, area);
+    textOverlay->paintBlocks(p, area);
+    p.end();
+
+    int bytesPerLine = exportCanvas.bytesPerLine();
+    uchar *slot = frameExport->beginFrame(size, bytesPerLine, FrameExport::Bgra);
+    if (!slot)
+        return;
+    std::memcpy(slot, exportCanvas.constBits(), size_t(bytesPerLine) * size.height());
+    frameExport->commitFrame();
+}
+
+// Video frames are read back by the video widget, at the size of the main
+// zone, and composed here with the zones and text blocks as on screen.
+void DisplayWidget::exportVideoFrame(const QImage &frame)
+{
+    TRACE_SPAN("export.video");
+    qreal scale = devicePixelRatioF();
+    QRect area(QPoint(), outputSize());
+    QRect main = mainArea().translated(-outputArea().topLeft());
+    QSize size = area.size() * scale;
+    int bytesPerLine = size.width() * 4;
+
+    // Usually the video covers the output, and the frame goes into the
+    // ring as it is, with the rest painted over it upside down.
+    if (main == area && frame.size() == size && frame.bytesPerLine() == bytesPerLine) {
+        uchar *slot = frameExport->beginFrame(size, bytesPerLine, FrameExport::RgbaBottomUp);
+        if (!slot)
+            return;
+        std::memcpy(slot, frame.constBits(), size_t(bytesPerLine) * size.height());
+        QImage composed(slot, size.width(), size.height(), bytesPerLine,
+                        QImage::Format_RGBA8888_Premultiplied);
+        QPainter p(&composed);
+        p.translate(0, size.height());
+        p.scale(scale, -scale);
+        for (OutputZone *zone : zones)
+            zone->paintZone(p, area);
+        textOverlay->paintBlocks(p, area);
+        p.end();
+        frameExport->commitFrame();
+        return;
+    }
+
+    uchar *slot = frameExport->beginFrame(size, bytesPerLine, FrameExport::Bgra);
+    if (!slot)
+        return;
+    QImage composed(slot, size.width(), size.height(), bytesPerLine,
+                    QImage::Format_ARGB32_Premultiplied);
+    composed.setDevicePixelRatio(scale);
+    QPainter p(&composed);
+    paintNothing(p, area);
+    p.save();
+    p.translate(main.left(), main.top() + main.height());
+    p.scale(1, -1);
+    p.drawImage(QRect(QPoint(), main.size()), frame);
+    p.restore();
+    for (OutputZone *zone : zones)
+        zone->paintZone(p, area);
+    textOverlay->paintBlocks(p, area);
+    p.end();
+    frameExport->commitFrame();
+}
+
+std::function<void(const QImage &frame)> DisplayWidget::videoFrameSink()
+{
+    if (!frameExport)
+        return VideoWidget::FrameSink();
+    return [this](const QImage &frame) { exportVideoFrame(frame); };
+}
+
+// Frames are exported from the main output only.
+void DisplayWidget::setFrameExport(FrameExport *frameExport)
+{
+    this->frameExport = frameExport;
+    if (videoWidget)
+        videoWidget->setFrameSink(videoFrameSink());
+    exportCanvas = QImage();
+    exportMemory.set(0);
+    exportDirty = QRegion();
+    update();
+}
+
+void DisplayWidget::setStreamCache(const StreamCache &cache)
+{
+    streamCache = cache;
+    if (videoWidget)
+        videoWidget->setStreamCache(cache);
+}
+
+// Text blocks are drawn over everything else, including video.
+void DisplayWidget::setOverlayText(TextOverlay::Block block, const QString &text)
+{
+    textOverlay->setText(block, text);
+}
+
+QString DisplayWidget::overlayText(TextOverlay::Block block) const
+{
+    return textOverlay->text(block);
+}
+
+void DisplayWidget::setClockVisible(bool visible)
+{
+    textOverlay->setClockVisible(visible);
+}
+
+QString DisplayWidget::streamStatsText() const
+{
+    return videoWidget ? videoWidget->streamStatsText() : QString();
+}
+
+void DisplayWidget::resizeEvent(QResizeEvent *e)
+{
+    QWidget::resizeEvent(e);
+    placeZones();
+}
+
 void DisplayWidget::mousePressEvent(QMouseEvent *event)
 {
-    if (event->button() == Qt::LeftButton && !widgetMode)
+    if (event->button() == Qt::LeftButton && !widgetMode && !source) {
         stop();
+        emit dismissed();
+    }
     QWidget::mousePressEvent(event);
 }
 
 void DisplayWidget::keyPressEvent(QKeyEvent *event)
 {
-    if (widgetMode)
+    if (widgetMode || source)
         goto end;
 
-    if (event->key() == Qt::Key_Escape)
+    if (event->key() == Qt::Key_Escape) {
         stop();
-    else if (event->key() == Qt::Key_Space && displayMode == DisplayingMedia)
+        emit dismissed();
+    } else if (event->key() == Qt::Key_Space && displayMode == DisplayingMedia)
         videoWidget->pauseResume();
 
     end:
     QWidget::keyPressEvent(event);
 }
 
-void DisplayWidget::paintNothing()
+// Mirrors follow the video widget being shown and hidden.
+bool DisplayWidget::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == videoWidget && (event->type() == QEvent::ShowToParent
+                                   || event->type() == QEvent::HideToParent))
+        syncMirrors();
+    return QWidget::eventFilter(watched, event);
+}
+
+// The painters below only depend on their arguments so that they can also
+// draw into offscreen images, e.g. for benchmarking.
+void DisplayWidget::paintNothing(QPainter &p, const QRect &area)
 {
     QColor bgColor(0,0,0);
-    QPainter p(this);
     p.setBackground(bgColor);
-    p.eraseRect(rect());
+    p.eraseRect(area);
 }
 
-void DisplayWidget::paintCountdown()
+void DisplayWidget::paintCountdown(QPainter &p, const QRect &area,
+                                   qint64 msecLeft, qint64 msecDuration)
 {
     QColor fillColor(0xff,0xff,0xba);
     QColor backColor(0x49,0x49,0x63);
     QColor bgColor(0,0,0);
 
-    int w = width();
-    int h = height();
+    int w = area.width();
+    int h = area.height();
     int d = std::min(w,h);
-    QPainter p(this);
+    p.save();
     p.setRenderHint(QPainter::Antialiasing);
-    QRect bgRect { 0, 0, width(), height() };
     p.setBackground(bgColor);
-    p.eraseRect(bgRect);
+    p.eraseRect(area);
+    p.translate(area.topLeft());
     p.translate(w > h ? QPoint((w-h)/2,0) : QPoint(0,(h-w)/2));
 
     QFont f;
@@ -250,19 +1071,23 @@ void DisplayWidget::paintCountdown()
     p.setBrush(bgColor);
     p.drawEllipse(QRectF(pieCenter - QPoint(radius2,radius2),
                          pieCenter + QPoint(radius2,radius2)));
+    p.restore();
 }
 
-void DisplayWidget::paintImage()
+void DisplayWidget::paintImage(QPainter &p, const QRect &area, const QImage &image,
+                               const QImage &previousImage, double transitionFactor)
 {
-    QSize picSize = image.size().scaled(size(), Qt::KeepAspectRatio);
-    QRect picRect = QStyle::alignedRect(Qt::LayoutDirectionAuto,
-                                        Qt::AlignCenter, picSize, rect());
     QColor bgColor(0,0,0);
-    QPainter p(this);
+    p.save();
     p.setBackground(bgColor);
-    p.eraseRect(rect());
+    p.eraseRect(area);
     p.setRenderHint(QPainter::SmoothPixmapTransform);
-    p.drawImage(picRect, image);
+    if (!previousImage.isNull()) {
+        p.drawImage(fitRect(previousImage.size(), area), previousImage);
+        p.setOpacity(transitionFactor);
+    }
+    p.drawImage(fitRect(image.size(), area), image);
+    p.restore();
 }
 
 void DisplayWidget::startFader(Fading effect)
@@ -270,15 +1095,21 @@ void DisplayWidget::startFader(Fading effect)
     if (widgetMode)
         return;
 
+    if ((standingBy || streamPending) && effect == FadingIn) {
+        standingBy = false;
+        streamPending = false;
+        windowHandle()->setFlag(Qt::WindowTransparentForInput, false);
+    }
     Fading priorMode = fadeMode;
     if ((priorMode == FadedIn && effect == FadingIn) ||
-        (priorMode == FadedOut && effect == FadingOut))
+        (priorMode == FadedOut && effect == FadingOut) ||
+        (priorMode == FadingOut && effect == FadingOut))
         return;
 
     if (priorMode == FadedOut && effect == FadingIn)
-        setWindowOpacity(0.0);
+        setOpacity(0.0);
     if (priorMode == FadedIn && effect == FadingOut)
-        setWindowOpacity(1.0);
+        setOpacity(1.0);
     if ((priorMode == FadingIn && effect == FadingOut) ||
         (priorMode == FadingOut && effect == FadingIn)) {
         fadeFactor = 1.0 - fadeFactor;
@@ -287,5 +1118,14 @@ void DisplayWidget::startFader(Fading effect)
     }
     fadeStart = QDateTime::currentDateTime();
     fadeMode = effect;
+    fadeFrameClock.start();
     fadeTimer.start();
 }
+
+// A tick that arrives half an interval late means a frame was dropped.
+void DisplayWidget::countFrame(QElapsedTimer &clock)
+{
+    if (clock.isValid() && clock.elapsed() > updateMsec * 3 / 2)
+        lateFrameCount++;
+    clock.start();
+}
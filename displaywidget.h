@@ -17,10 +17,22 @@
 #ifndef DISPLAYWIDGET_H
 #define DISPLAYWIDGET_H
 
+#include <functional>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QRegion>
 #include <QTimer>
 #include <QWidget>
+#include "common.h"
+#include "jobscheduler.h"
+#include "memorybudget.h"
+#include "outputzone.h"
+#include "textoverlay.h"
 
+class FrameExport;
+class QPainter;
+class VideoMirror;
 class VideoWidget;
 
 class DisplayWidget : public QWidget
@@ -30,13 +42,71 @@ class DisplayWidget : public QWidget
     enum Fading { FadedOut, FadingIn, FadedIn, FadingOut };
 
 public:
+    static constexpr qint64 fadeTimeMsec = 300;
+    static constexpr qint64 updateMsec = 1000/20;
+    static constexpr qint64 transitionTimeMsec = 600;
+
     explicit DisplayWidget(QWidget *parent = nullptr, bool widgetMode = false);
     ~DisplayWidget();
     void startCountdown(int msecDuration);
     void startCountdownPartway(int msecPosition, int msecDuration);
+    void setCountdownBackground(const QString &filename);
     void displayFile(const QString &filename);
+    void displayImage(const QImage &prepared, bool crossfade);
+    int lateFrames() const;
+    void prepareVideo();
+
+    void standbyCountdown(int msecDuration);
+    void standbyImage(const QImage &prepared);
+    void standbyMedia(const QString &filename, int msecIn = 0, int msecOut = 0);
+    bool isStandingBy() const;
+    bool isShown() const;
+    QDateTime countdownEnd() const;
+    void take();
+    void cut();
+
+    void addMirror(DisplayWidget *mirror);
+    void removeMirror(DisplayWidget *mirror);
+    void moveOutputsTo(DisplayWidget *other);
+    void setTile(const QSize &canvas, const QRect &tile);
+    void setZoneLayout(const ZoneLayout &layout);
+    void setZoneImage(int index, const QImage &image);
+    QSize outputSize() const;
+    QSize contentSize() const;
+    void setFrameExport(FrameExport *frameExport);
+    void setStreamCache(const StreamCache &cache);
+    void setOverlayText(TextOverlay::Block block, const QString &text);
+    QString overlayText(TextOverlay::Block block) const;
+    void setClockVisible(bool visible);
+    QString streamStatsText() const;
+    void setVisible(bool visible) Q_DECL_OVERRIDE;
+
+    static bool isMediaFile(const QString &filename);
+    static bool isStreamUrl(const QString &filename);
+    static QImage prepareImage(const QString &filename, const QSize &size,
+                               const JobScheduler::Job *job = nullptr);
+    static JobScheduler::Handle prepareImageJob(JobScheduler::Priority priority,
+                                                const QString &filename, const QSize &size,
+                                                QObject *context,
+                                                const std::function<void(const QImage &)> &done);
+
+    static void paintNothing(QPainter &p, const QRect &area);
+    static void paintCountdown(QPainter &p, const QRect &area,
+                               qint64 msecLeft, qint64 msecDuration);
+    static void paintImage(QPainter &p, const QRect &area, const QImage &image,
+                           const QImage &previousImage = QImage(),
+                           double transitionFactor = 1.0);
 
 signals:
+    // Pipeline stages of the most recent start, for latency measurement.
+    void contentReady();
+    void framePainted();
+    void fadedIn();
+    void fadedOut();
+    void countdownStarted(const QDateTime &endTime);
+    // The operator clicked the output or pressed Esc on it.
+    void dismissed();
+    void streamStatsChanged();
 
 public slots:
     void stop();
@@ -44,20 +114,41 @@ public slots:
 private slots:
     void timer_timeout();
     void fadeTimer_timeout();
+    void transitionTimer_timeout();
+    void releaseMemory();
 
 protected:
     void paintEvent(QPaintEvent *e);
+    void resizeEvent(QResizeEvent *e) Q_DECL_OVERRIDE;
     void mousePressEvent(QMouseEvent *event);
     void keyPressEvent(QKeyEvent *event);
+    bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
 
 private:
-    void paintNothing();
-    void paintCountdown();
-    void paintImage();
     void startFader(Fading effect);
+    void countFrame(QElapsedTimer &clock);
+    void accountImages();
+    void stopVideo();
+    void enterStandby();
+    void awaitStream();
+    void setOpacity(qreal opacity);
+    void syncMirrors();
+    void showVideoMirror(bool show);
+    QRect outputArea() const;
+    QRect mainArea() const;
+    void placeZones();
+    void raiseOverlays();
+    void updateMain();
+    void setZoneCountdown(const QDateTime &endTime, qint64 msecDuration);
+    void paintShown(QPainter &p, const QRect &area);
+    bool isVideoShown() const;
+    void queueExport(const QRect &dirty);
+    void exportFrame();
+    void exportVideoFrame(const QImage &frame);
+    std::function<void(const QImage &frame)> videoFrameSink();
 
 private:
-    VideoWidget *videoWidget;
+    VideoWidget *videoWidget = nullptr;
     Displaying displayMode;
     bool widgetMode;
 
@@ -65,6 +156,8 @@ private:
     qint64 msecLeft;
     qint64 msecDuration;
     QDateTime endTime;
+    QDateTime zoneCountdownEnd;
+    QString countdownBackground;
 
     QDateTime fadeStart;
     QTimer fadeTimer;
@@ -72,6 +165,33 @@ private:
     double fadeFactor = 0.0;
 
     QImage image;
+    QImage previousImage;
+    QElapsedTimer transitionClock;
+    QTimer transitionTimer;
+    double transitionFactor = 1.0;
+    MemoryBudget::Account imageMemory { MemoryBudget::DisplayImages };
+
+    QElapsedTimer fadeFrameClock;
+    QElapsedTimer transitionFrameClock;
+    int lateFrameCount = 0;
+    bool framePending = false;
+    bool standingBy = false;
+    bool streamPending = false;
+    StreamCache streamCache;
+
+    DisplayWidget *source = nullptr;
+    QList<DisplayWidget*> mirrors;
+    VideoMirror *videoMirror = nullptr;
+    TextOverlay *textOverlay;
+    ZoneLayout zoneLayout;
+    QList<OutputZone*> zones;
+    QSize canvas;
+    QRect tile;
+    FrameExport *frameExport = nullptr;
+    QImage exportCanvas;
+    MemoryBudget::Account exportMemory { MemoryBudget::FrameSharing };
+    QRegion exportDirty;
+    bool exportQueued = false;
 };
 
 #endif // DISPLAYWIDGET_H
@@ -0,0 +1,228 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <atomic>
+#include <new>
+#include "frameexport.h"
+#include "trace.h"
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static constexpr quint32 exportMagic = 0x46535250;     // "PRSF"
+static constexpr quint32 exportVersion = 1;
+static constexpr size_t headerBytes = 4096;
+static constexpr size_t slotHeaderBytes = 64;
+
+struct FrameExport::Header {
+    quint32 magic;
+    quint32 version;
+    quint32 depth;
+    quint32 maxWidth;
+    quint32 maxHeight;
+    quint32 reserved;
+    quint64 slotOffset;
+    quint64 slotBytes;
+    std::atomic<quint64> latest;
+    std::atomic<quint64> dropped;
+};
+
+struct FrameExport::Slot {
+    std::atomic<quint64> sequence;
+    qint64 timestampNsec;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format;
+};
+
+static_assert(sizeof(std::atomic<quint64>) == 8, "shared counters must be plain words");
+
+FrameExport::FrameExport(QObject *parent) : QObject(parent)
+{
+    statsTimer.setInterval(statsMsec);
+    connect(&statsTimer, &QTimer::timeout, this, &FrameExport::statsChanged);
+}
+
+FrameExport::~FrameExport()
+{
+    close();
+}
+
+QString FrameExport::defaultName()
+{
+    return "/presenter-frames-" + qEnvironmentVariable("USER");
+}
+
+bool FrameExport::open(const QString &name, const QSize &maxSize, int depth)
+{
+    close();
+#ifdef Q_OS_UNIX
+    if (maxSize.isEmpty() || depth < 2) {
+        error = tr("Invalid frame size or ring depth");
+        return false;
+    }
+    size_t slotBytes = slotHeaderBytes + size_t(maxSize.width()) * maxSize.height() * 4;
+    slotBytes = (slotBytes + 4095) & ~size_t(4095);
+    size_t total = headerBytes + slotBytes * depth;
+
+    QByteArray cName = name.toUtf8();
+    int fd = shm_open(cName.constData(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) {
+        error = QString::fromLocal8Bit(strerror(errno));
+        return false;
+    }
+    void *p = MAP_FAILED;
+    if (ftruncate(fd, off_t(total)) == 0)
+        p = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int savedErrno = errno;
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        error = QString::fromLocal8Bit(strerror(savedErrno));
+        shm_unlink(cName.constData());
+        return false;
+    }
+
+    mapping = static_cast<uchar*>(p);
+    mappingSize = total;
+    mappingMemory.set(qint64(total));
+    shmName = name;
+    header = new (mapping) Header;
+    header->version = exportVersion;
+    header->depth = quint32(depth);
+    header->maxWidth = quint32(maxSize.width());
+    header->maxHeight = quint32(maxSize.height());
+    header->reserved = 0;
+    header->slotOffset = headerBytes;
+    header->slotBytes = slotBytes;
+    header->latest = 0;
+    header->dropped = 0;
+    for (int i = 0; i < depth; i++)
+        new (mapping + headerBytes + slotBytes * i) Slot { {0}, 0, 0, 0, 0, 0 };
+    sequence = 0;
+    // Readers check the magic last, once everything else is in place.
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = exportMagic;
+    statsTimer.start();
+    emit statsChanged();
+    return true;
+#else
+    Q_UNUSED(name);
+    Q_UNUSED(maxSize);
+    Q_UNUSED(depth);
+    error = tr("Shared memory frame export is not supported on this platform");
+    return false;
+#endif
+}
+
+void FrameExport::close()
+{
+#ifdef Q_OS_UNIX
+    if (!mapping)
+        return;
+    if (writing)
+        commitFrame();
+    header->magic = 0;
+    munmap(mapping, mappingSize);
+    shm_unlink(shmName.toUtf8().constData());
+    mapping = nullptr;
+    header = nullptr;
+    mappingMemory.set(0);
+    statsTimer.stop();
+    emit statsChanged();
+#endif
+}
+
+bool FrameExport::isOpen() const
+{
+    return header;
+}
+
+QString FrameExport::errorString() const
+{
+    return error;
+}
+
+uchar *FrameExport::beginFrame(const QSize &size, int bytesPerLine, Format format)
+{
+    if (!header)
+        return nullptr;
+    if (size.isEmpty() || size_t(bytesPerLine) * size.height()
+            > header->slotBytes - slotHeaderBytes) {
+        header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    writing = slot(sequence + 1);
+    writing->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    writing->width = quint32(size.width());
+    writing->height = quint32(size.height());
+    writing->bytesPerLine = quint32(bytesPerLine);
+    writing->format = format;
+    return reinterpret_cast<uchar*>(writing) + slotHeaderBytes;
+}
+
+void FrameExport::commitFrame()
+{
+    if (!writing)
+        return;
+    TRACE_SPAN("export.commit");
+    sequence++;
+#ifdef Q_OS_UNIX
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    writing->timestampNsec = qint64(now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
+    writing->sequence.store(sequence, std::memory_order_release);
+    header->latest.store(sequence, std::memory_order_release);
+    writing = nullptr;
+}
+
+FrameExport::Slot *FrameExport::slot(quint64 sequence) const
+{
+    quint64 index = (sequence - 1) % header->depth;
+    return reinterpret_cast<Slot*>(mapping + header->slotOffset
+                                   + header->slotBytes * index);
+}
+
+int FrameExport::depth() const
+{
+    return header ? int(header->depth) : 0;
+}
+
+quint64 FrameExport::published() const
+{
+    return sequence;
+}
+
+quint64 FrameExport::dropped() const
+{
+    return header ? header->dropped.load(std::memory_order_relaxed) : 0;
+}
+
+QString FrameExport::statsText() const
+{
+    if (!header)
+        return QString();
+    return tr("Sharing %1: %2 frames, %3 dropped, %4 deep")
+            .arg(shmName).arg(published()).arg(dropped()).arg(depth());
+}
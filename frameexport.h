@@ -0,0 +1,95 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef FRAMEEXPORT_H
+#define FRAMEEXPORT_H
+
+#include <QObject>
+#include <QSize>
+#include <QTimer>
+#include "memorybudget.h"
+
+// Publishes composed output frames, with zones and text blocks over stills
+// and video alike, into a POSIX shared-memory ring, so that capture and
+// streaming software on the same machine can read them without grabbing
+// the screen.  The writer never waits for readers; a reader that
+// falls more than depth - 1 frames behind sees gaps in the sequence numbers.
+//
+// Layout, in native byte order: a 4096 byte header
+//     quint32 magic ('PRSF'), quint32 version, quint32 depth,
+//     quint32 maxWidth, quint32 maxHeight, quint32 reserved,
+//     quint64 slotOffset, quint64 slotBytes, quint64 latest, quint64 dropped
+// then depth slots of slotBytes each.  A slot starts with a 64 byte header
+//     quint64 sequence, qint64 timestampNsec,
+//     quint32 width, quint32 height, quint32 bytesPerLine, quint32 format
+// and the pixels follow at offset 64.  Timestamps are CLOCK_MONOTONIC.
+// Format 1 is premultiplied BGRA (QImage::Format_ARGB32_Premultiplied on
+// little-endian hosts) with the top row first; format 2 is premultiplied
+// RGBA with the bottom row first, as read back from GL.
+//
+// Sequences start at 1.  The writer zeroes a slot's sequence before filling
+// it, then stores the sequence and finally latest.  To read, take latest,
+// read slot (latest - 1) % depth, and discard the frame if the slot's
+// sequence no longer equals latest.
+class FrameExport : public QObject
+{
+    Q_OBJECT
+public:
+    enum Format : quint32 { Bgra = 1, RgbaBottomUp = 2 };
+
+    explicit FrameExport(QObject *parent = nullptr);
+    ~FrameExport();
+
+    static QString defaultName();
+
+    bool open(const QString &name, const QSize &maxSize, int depth);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    // The slot to write a frame into, or nullptr when the frame does not
+    // fit, which counts as a drop.  Every slot returned must be committed.
+    uchar *beginFrame(const QSize &size, int bytesPerLine, Format format);
+    void commitFrame();
+
+    int depth() const;
+    quint64 published() const;
+    quint64 dropped() const;
+    QString statsText() const;
+
+signals:
+    void statsChanged();
+
+private:
+    struct Header;
+    struct Slot;
+
+    Slot *slot(quint64 sequence) const;
+
+    static constexpr int statsMsec = 1000;
+
+    QString shmName;
+    QString error;
+    uchar *mapping = nullptr;
+    size_t mappingSize = 0;
+    MemoryBudget::Account mappingMemory { MemoryBudget::FrameSharing };
+    Header *header = nullptr;
+    Slot *writing = nullptr;
+    quint64 sequence = 0;
+    QTimer statsTimer;
+};
+
+#endif // FRAMEEXPORT_H
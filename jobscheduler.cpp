@@ -0,0 +1,269 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <algorithm>
+#include <QCoreApplication>
+#include <QThread>
+#include "jobscheduler.h"
+#include "trace.h"
+
+static thread_local int currentWorker = -1;
+
+static const char *const spanNames[JobScheduler::PriorityCount] = {
+    "job.onAir", "job.nextUp", "job.preview", "job.indexing"
+};
+
+JobScheduler *JobScheduler::instance()
+{
+    static JobScheduler *scheduler = new JobScheduler(qApp);
+    return scheduler;
+}
+
+// At least three workers, so that on-air, preview and indexing work can
+// each have one even on a dual-core machine.
+JobScheduler::JobScheduler(QObject *parent) : QObject(parent)
+{
+    workers.resize(std::max(QThread::idealThreadCount(), 3));
+    for (int i = 0; i < workers.count(); i++) {
+        workers[i].thread = QThread::create([this, i]() { runWorker(i); });
+        workers[i].thread->setObjectName(QString("job worker %1").arg(i));
+        workers[i].thread->start();
+    }
+}
+
+// Queued jobs are abandoned; running ones are waited for.
+JobScheduler::~JobScheduler()
+{
+    mutex.lock();
+    quitting = true;
+    workAvailable.wakeAll();
+    mutex.unlock();
+    for (Worker &w : workers) {
+        w.thread->wait();
+        delete w.thread;
+    }
+}
+
+int JobScheduler::workerCount() const
+{
+    return workers.count();
+}
+
+JobScheduler::Handle JobScheduler::submit(Priority priority, const QString &key,
+                                          const Work &work, QObject *context,
+                                          const Done &done)
+{
+    Handle handle;
+    handle.request.reset(new Handle::Request);
+    handle.request->context = context;
+    handle.request->hasContext = context;
+    handle.request->done = done;
+
+    QMutexLocker lock(&mutex);
+    QSharedPointer<Job> job = key.isEmpty() ? QSharedPointer<Job>() : shared.value(key);
+    // A cancelled job that has started may already have given up.
+    if (job && job->started && job->isCancelled())
+        job.reset();
+    if (job && job->started) {
+        job->interest++;
+    } else if (job) {
+        job->interest++;
+        if (priority < job->priority) {
+            // Queued again in the higher class; the old entry is skipped.
+            job->priority = priority;
+            workers[nextWorker].queues[priority].push_back(job);
+            nextWorker = (nextWorker + 1) % workers.count();
+        }
+    } else {
+        job.reset(new Job);
+        job->key = key;
+        job->priority = priority;
+        job->work = work;
+        job->interest = 1;
+        if (!key.isEmpty())
+            shared.insert(key, job);
+        // Work submitted from a worker stays with it unless stolen.
+        int index = currentWorker;
+        if (index < 0) {
+            index = nextWorker;
+            nextWorker = (nextWorker + 1) % workers.count();
+        }
+        workers[index].queues[priority].push_back(job);
+    }
+    handle.request->job = job;
+    requests[job.data()].append(handle.request);
+    workAvailable.wakeAll();
+    return handle;
+}
+
+void JobScheduler::map(Priority priority, int count, const std::function<void(int)> &work)
+{
+    std::atomic<int> next { 0 };
+    auto runItems = [&]() {
+        for (int i; (i = next.fetch_add(1)) < count; )
+            work(i);
+    };
+    QList<Handle> helpers;
+    int helperCount = std::min(count, workers.count()) - 1;
+    for (int i = 0; i < helperCount; i++)
+        helpers.append(submit(priority, QString(), [&](const Job &) {
+            runItems();
+            return QVariant();
+        }));
+    runItems();
+    // Helpers that never started have nothing left to do.
+    for (Handle &h : helpers) {
+        h.cancel();
+        h.wait();
+    }
+}
+
+// Lower classes leave one worker free for on-air and next-up work, and
+// indexing leaves at least one of the rest free for previews.
+bool JobScheduler::mayStart(int priority) const
+{
+    int limit = workers.count() - 1;
+    if (priority == Preview)
+        return running[Preview] + running[Indexing] < limit;
+    if (priority == Indexing)
+        return running[Preview] + running[Indexing] < limit
+                && running[Indexing] < limit / 2;
+    return true;
+}
+
+// The worker's own newest job first, then the oldest from any other
+// worker, class by class.
+QSharedPointer<JobScheduler::Job> JobScheduler::take(int index)
+{
+    for (int p = 0; p < PriorityCount; p++) {
+        if (!mayStart(p))
+            continue;
+        for (int n = 0; n < workers.count(); n++) {
+            Worker &w = workers[(index + n) % workers.count()];
+            std::deque<QSharedPointer<Job>> &queue = w.queues[p];
+            while (!queue.empty()) {
+                QSharedPointer<Job> job;
+                if (n == 0) {
+                    job = queue.back();
+                    queue.pop_back();
+                } else {
+                    job = queue.front();
+                    queue.pop_front();
+                }
+                // Entries left behind by a priority raise or a cancel.
+                if (job->started || job->finished || job->priority != p)
+                    continue;
+                if (job->isCancelled()) {
+                    drop(job);
+                    continue;
+                }
+                return job;
+            }
+        }
+    }
+    return QSharedPointer<Job>();
+}
+
+void JobScheduler::runWorker(int index)
+{
+    currentWorker = index;
+    QMutexLocker lock(&mutex);
+    while (!quitting) {
+        QSharedPointer<Job> job = take(index);
+        if (!job) {
+            workAvailable.wait(&mutex);
+            continue;
+        }
+        int priority = job->priority;
+        job->started = true;
+        running[priority]++;
+        lock.unlock();
+        QVariant result;
+        {
+            TRACE_SPAN(spanNames[priority]);
+            result = job->work(*job);
+        }
+        lock.relock();
+        running[priority]--;
+        finish(job, result);
+        // A lower class may have been waiting for this slot.
+        workAvailable.wakeAll();
+    }
+}
+
+// Results go through the GUI thread, where contexts are destroyed, so a
+// context is never used after it has gone.
+void JobScheduler::finish(const QSharedPointer<Job> &job, const QVariant &result)
+{
+    job->finished = true;
+    job->work = nullptr;
+    if (shared.value(job->key) == job)
+        shared.remove(job->key);
+    for (const auto &request : requests.take(job.data())) {
+        if (!request->done || request->cancelled)
+            continue;
+        QMetaObject::invokeMethod(this, [request, result]() {
+            if (!request->cancelled && (!request->hasContext || request->context))
+                request->done(result);
+        }, Qt::QueuedConnection);
+    }
+    jobFinished.wakeAll();
+}
+
+void JobScheduler::drop(const QSharedPointer<Job> &job)
+{
+    finish(job, QVariant());
+}
+
+void JobScheduler::Handle::cancel()
+{
+    if (!request)
+        return;
+    JobScheduler *s = instance();
+    QMutexLocker lock(&s->mutex);
+    if (request->cancelled.exchange(true))
+        return;
+    QSharedPointer<Job> job = request->job;
+    if (--job->interest <= 0 && !job->started && !job->finished)
+        s->drop(job);
+}
+
+bool JobScheduler::Handle::isActive() const
+{
+    if (!request)
+        return false;
+    QMutexLocker lock(&instance()->mutex);
+    return !request->cancelled && !request->job->finished;
+}
+
+// Cancelled requests are finished once their job has stopped running.
+bool JobScheduler::Handle::isFinished() const
+{
+    if (!request)
+        return true;
+    QMutexLocker lock(&instance()->mutex);
+    return request->job->finished;
+}
+
+void JobScheduler::Handle::wait()
+{
+    if (!request)
+        return;
+    JobScheduler *s = instance();
+    QMutexLocker lock(&s->mutex);
+    while (!request->job->finished)
+        s->jobFinished.wait(&s->mutex);
+}
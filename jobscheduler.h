@@ -0,0 +1,148 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef JOBSCHEDULER_H
+#define JOBSCHEDULER_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QPointer>
+#include <QSharedPointer>
+#include <QVariant>
+#include <QVector>
+#include <QWaitCondition>
+
+class QThread;
+
+// Runs decoding, staging and rendering work on a bounded set of worker
+// threads, in four priority classes.  Each worker has its own queues and
+// takes work from the others when they run dry, always from the highest
+// class first.  Preview and indexing work may never occupy every worker,
+// so on-air and next-up work always has a thread to start on at once, and
+// indexing may never occupy all of the rest, so previews always have one.
+//
+// Requests with the same key while one is queued or running share it.  A
+// job whose requests have all been cancelled is dropped if it has not
+// started, and sees Job::isCancelled() if it has; results of cancelled
+// requests are never delivered.
+class JobScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority { OnAir, NextUp, Preview, Indexing, PriorityCount };
+
+    class Handle;
+
+    class Job
+    {
+    public:
+        bool isCancelled() const { return interest.load(std::memory_order_relaxed) <= 0; }
+
+    private:
+        friend class JobScheduler;
+        friend class Handle;
+        QString key;
+        int priority;
+        std::function<QVariant(const Job &)> work;
+        std::atomic<int> interest { 0 };
+        bool started = false;
+        bool finished = false;
+    };
+
+    typedef std::function<QVariant(const Job &job)> Work;
+    typedef std::function<void(const QVariant &result)> Done;
+
+    // One request for a job; copies refer to the same request.
+    class Handle
+    {
+    public:
+        void cancel();
+        bool isActive() const;
+        bool isFinished() const;
+        void wait();
+
+    private:
+        friend class JobScheduler;
+        struct Request {
+            QSharedPointer<Job> job;
+            QPointer<QObject> context;
+            bool hasContext = false;
+            Done done;
+            std::atomic<bool> cancelled { false };
+        };
+        QSharedPointer<Request> request;
+    };
+
+    static JobScheduler *instance();
+    ~JobScheduler();
+
+    // done is called on the GUI thread, unless the request was cancelled
+    // or context has gone.  An empty key is never shared.
+    Handle submit(Priority priority, const QString &key, const Work &work,
+                  QObject *context = nullptr, const Done &done = Done());
+    template <typename T>
+    Handle compute(Priority priority, const QString &key,
+                   const std::function<T(const Job &)> &work, QObject *context,
+                   const std::function<void(const T &)> &done);
+
+    // Calls work(0) to work(count - 1) on the workers and the calling
+    // thread, returning when all are done.
+    void map(Priority priority, int count, const std::function<void(int)> &work);
+
+    int workerCount() const;
+
+private:
+    explicit JobScheduler(QObject *parent = nullptr);
+    void runWorker(int index);
+    QSharedPointer<Job> take(int index);
+    bool mayStart(int priority) const;
+    void finish(const QSharedPointer<Job> &job, const QVariant &result);
+    void drop(const QSharedPointer<Job> &job);
+
+    struct Worker {
+        QThread *thread = nullptr;
+        std::deque<QSharedPointer<Job>> queues[PriorityCount];
+    };
+
+    mutable QMutex mutex;
+    QWaitCondition workAvailable;
+    QWaitCondition jobFinished;
+    QVector<Worker> workers;
+    QHash<QString,QSharedPointer<Job>> shared;
+    QHash<Job*,QList<QSharedPointer<Handle::Request>>> requests;
+    int running[PriorityCount] = {};
+    int nextWorker = 0;
+    bool quitting = false;
+};
+
+template <typename T>
+JobScheduler::Handle JobScheduler::compute(Priority priority, const QString &key,
+                                           const std::function<T(const Job &)> &work,
+                                           QObject *context,
+                                           const std::function<void(const T &)> &done)
+{
+    return submit(priority, key,
+                  [work](const Job &job) { return QVariant::fromValue(work(job)); },
+                  context,
+                  [done](const QVariant &result) { done(result.value<T>()); });
+}
+
+#endif // JOBSCHEDULER_H
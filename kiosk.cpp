@@ -0,0 +1,107 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QDebug>
+#include "kiosk.h"
+#include "trace.h"
+
+// Dwell for bundle items saved without one.
+constexpr int defaultDwellMsec = 5000;
+
+Kiosk::Kiosk(QObject *parent) : QObject(parent), slideshow(&display)
+{
+    slideshow.setLoop(true);
+    slideshow.setCrossfade(true);
+    slideshow.setDwell(defaultDwellMsec);
+    connect(&slideshow, &Slideshow::itemShown, this, [this](int index) {
+        loopIndex = index;
+    });
+    connect(&display, &DisplayWidget::fadedOut, this, [this]() {
+        countingDown = false;
+        if (!slideshow.isRunning())
+            resumeLoop();
+    });
+}
+
+Kiosk::~Kiosk()
+{
+    slideshow.stop();
+}
+
+bool Kiosk::open(const QString &path)
+{
+    TRACE_SPAN("kiosk.open");
+    if (!bundle.open(path))
+        return false;
+
+    // Frames are used even if the bundle was made for another output size;
+    // the source files need not exist on this machine.
+    QList<Slideshow::Item> items;
+    for (const ShowBundle::Item &b : bundle.items()) {
+        Slideshow::Item item;
+        item.filename = b.filename;
+        item.dwellMsec = b.dwellSeconds * 1000;
+        item.frame = b.frame;
+        items.append(item);
+    }
+    slideshow.setItems(items);
+    countdowns = bundle.countdowns();
+    return true;
+}
+
+QString Kiosk::errorString() const
+{
+    return bundle.errorString();
+}
+
+void Kiosk::setGeometry(const QRect &geometry)
+{
+    this->geometry = geometry;
+    display.setGeometry(geometry);
+}
+
+void Kiosk::start()
+{
+    for (auto c : countdowns) {
+        c->updateTimer();
+        Countdown *cData = c.data();
+        connect(c->timer.data(), &QTimer::timeout, this, [this,cData]() {
+            startCountdown(cData);
+            cData->updateTimer();
+            cData->timer->start();
+        });
+        c->timer->start();
+    }
+    qInfo().noquote() << QString("kiosk: %1 items, %2 countdowns")
+                         .arg(bundle.items().count()).arg(countdowns.count());
+    resumeLoop();
+}
+
+void Kiosk::startCountdown(Countdown *c)
+{
+    countingDown = true;
+    slideshow.stop();
+    display.setGeometry(geometry);
+    display.startCountdown(c->duration.msecsSinceStartOfDay());
+}
+
+void Kiosk::resumeLoop()
+{
+    if (countingDown || bundle.items().isEmpty())
+        return;
+    display.setGeometry(geometry);
+    slideshow.start(loopIndex + 1 < bundle.items().count() ? loopIndex + 1 : 0);
+}
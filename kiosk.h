@@ -0,0 +1,57 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef KIOSK_H
+#define KIOSK_H
+
+#include <QList>
+#include <QObject>
+#include <QRect>
+#include <QSharedPointer>
+#include "common.h"
+#include "displaywidget.h"
+#include "showbundle.h"
+#include "slideshow.h"
+
+// Unattended playback of a show bundle without the operator window: the
+// bundle's stills and videos loop on the output, and its countdowns
+// interrupt the loop when they fall due.
+class Kiosk : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Kiosk(QObject *parent = nullptr);
+    ~Kiosk();
+
+    bool open(const QString &path);
+    QString errorString() const;
+    void setGeometry(const QRect &geometry);
+    void start();
+
+private:
+    void startCountdown(Countdown *c);
+    void resumeLoop();
+
+    ShowBundle bundle;
+    DisplayWidget display;
+    Slideshow slideshow;
+    QList<QSharedPointer<Countdown>> countdowns;
+    QRect geometry;
+    int loopIndex = -1;
+    bool countingDown = false;
+};
+
+#endif // KIOSK_H
@@ -0,0 +1,263 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+// Trigger-to-first-frame latency harness.  Build with
+//     qmake CONFIG+=latency && make
+// and run presenter-latency [files...].  It drives MainWindow's Show button
+// and countdown timers on the offscreen platform, with mpv on a null video
+// output, and prints per-stage latency distributions as JSON.  Without
+// files it generates a small corpus of stills.
+
+#include <algorithm>
+#include <functional>
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include "mainwindow.h"
+#include "ui_mainwindow.h"
+#include "videowidget.h"
+
+static const QStringList stageNames {
+    "geometry", "decode", "firstPaint", "fadeComplete"
+};
+
+static bool waitUntil(const std::function<bool()> &done, int timeoutMsec)
+{
+    QElapsedTimer clock;
+    clock.start();
+    QTimer tick;
+    tick.start(5);
+    QEventLoop loop;
+    while (!done() && clock.elapsed() < timeoutMsec)
+        loop.processEvents(QEventLoop::WaitForMoreEvents);
+    return done();
+}
+
+static QJsonObject distribution(QList<double> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        return samples[std::min(int(q * samples.count()), samples.count() - 1)];
+    };
+    return QJsonObject {
+        { "samples", samples.count() },
+        { "minMsec", samples.first() },
+        { "p50Msec", at(0.50) },
+        { "p90Msec", at(0.90) },
+        { "p99Msec", at(0.99) },
+        { "maxMsec", samples.last() }
+    };
+}
+
+class LatencyHarness
+{
+public:
+    explicit LatencyHarness(MainWindow &w) : w(w)
+    {
+        QObject::connect(&w, &MainWindow::displayGeometryApplied,
+                         [this]() { mark("geometry"); });
+        for (DisplayWidget *d : { &w.displayWidget, &w.standbyWidget }) {
+            QObject::connect(d, &DisplayWidget::contentReady,
+                             [this]() { mark("decode"); });
+            QObject::connect(d, &DisplayWidget::framePainted,
+                             [this]() { mark("firstPaint"); });
+            QObject::connect(d, &DisplayWidget::fadedIn,
+                             [this]() { mark("fadeComplete"); });
+        }
+    }
+
+    void runFile(const QString &filename, int runs)
+    {
+        w.on_imagesClear_clicked();
+        w.appendImages({filename});
+        w.ui->imagesList->setCurrentRow(0);
+        for (int i = 0; i < runs; i++) {
+            begin();
+            w.on_imagesShow_clicked();
+            finish(DisplayWidget::isMediaFile(filename) ? "video" : "image",
+                   filename);
+        }
+    }
+
+    void runCountdown(int runs)
+    {
+        for (int i = 0; i < runs; i++) {
+            QSharedPointer<Countdown> c(new Countdown);
+            c->duration = QTime(0, 0, 5);
+            // Connected before MainWindow's handler, so it fires first.
+            QObject::connect(c->timer.data(), &QTimer::timeout,
+                             [this]() { begin(); });
+            w.scheduleCountdown(c);
+            c->timer->start(10);
+            waitUntil([this]() { return armed; }, 1000);
+            finish("countdown", QString());
+            w.on_countdownClear_clicked();
+        }
+    }
+
+    QJsonArray report() const
+    {
+        QJsonArray out;
+        for (auto i = samples.constBegin(); i != samples.constEnd(); ++i) {
+            QJsonObject stages;
+            for (auto j = i.value().constBegin(); j != i.value().constEnd(); ++j)
+                stages[j.key()] = distribution(j.value());
+            out.append(QJsonObject {
+                { "kind", i.key().first },
+                { "file", i.key().second },
+                { "failures", failures.value(i.key()) },
+                { "stages", stages }
+            });
+        }
+        return out;
+    }
+
+private:
+    void begin()
+    {
+        marks.clear();
+        armed = true;
+        clock.start();
+    }
+
+    void mark(const QString &stage)
+    {
+        if (armed && !marks.contains(stage))
+            marks.insert(stage, clock.nsecsElapsed() / 1e6);
+    }
+
+    void finish(const QString &kind, const QString &filename)
+    {
+        Key key(kind, filename);
+        bool done = waitUntil([this]() {
+            return marks.contains("fadeComplete") && marks.contains("firstPaint");
+        }, 10000);
+        armed = false;
+        if (done) {
+            for (const QString &stage : stageNames)
+                if (marks.contains(stage))
+                    samples[key][stage].append(marks[stage]);
+        } else {
+            failures[key]++;
+        }
+
+        bool hidden = false;
+        auto connection = QObject::connect(&w.displayWidget, &DisplayWidget::fadedOut,
+                                           [&hidden]() { hidden = true; });
+        w.displayWidget.stop();
+        waitUntil([&hidden]() { return hidden; }, 2000);
+        QObject::disconnect(connection);
+    }
+
+    typedef QPair<QString,QString> Key;
+
+    MainWindow &w;
+    QElapsedTimer clock;
+    bool armed = false;
+    QHash<QString,double> marks;
+    QMap<Key,QMap<QString,QList<double>>> samples;
+    QMap<Key,int> failures;
+};
+
+static QStringList syntheticCorpus(const QString &dir)
+{
+    QStringList files;
+    const QList<QSize> sizes { { 1920, 1080 }, { 3840, 2160 } };
+    for (const QSize &size : sizes) {
+        for (const char *ext : { "png", "jpg" }) {
+            QImage image(size, QImage::Format_RGB32);
+            QPainter p(&image);
+            QLinearGradient g(0, 0, size.width(), size.height());
+            g.setColorAt(0, Qt::darkBlue);
+            g.setColorAt(1, Qt::darkYellow);
+            p.fillRect(image.rect(), g);
+            p.end();
+            QString name = QString("%1/%2x%3.%4").arg(dir).arg(size.width())
+                    .arg(size.height()).arg(ext);
+            if (image.save(name))
+                files.append(name);
+        }
+    }
+    return files;
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    // Keep the operator's settings and show journal out of reach.
+    QCoreApplication::setOrganizationName("PresenterDevs");
+    QCoreApplication::setApplicationName("PresenterLatency");
+    QApplication a(argc, argv);
+    setlocale(LC_NUMERIC, "C");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Presenter trigger-to-frame latency harness");
+    parser.addHelpOption();
+    QCommandLineOption runsOption("runs", "Runs per corpus item.", "n", "20");
+    QCommandLineOption voOption("vo", "mpv video output.", "vo", "null");
+    QCommandLineOption outputOption("output", "Write JSON to a file.", "file");
+    parser.addOption(runsOption);
+    parser.addOption(voOption);
+    parser.addOption(outputOption);
+    parser.addPositionalArgument("files", "Images and videos to trigger.");
+    parser.process(a);
+
+    VideoWidget::setVideoOutput(parser.value(voOption));
+    a.setQuitOnLastWindowClosed(false);
+    int runs = std::max(parser.value(runsOption).toInt(), 1);
+
+    QTemporaryDir corpusDir;
+    QStringList files = parser.positionalArguments();
+    if (files.isEmpty())
+        files = syntheticCorpus(corpusDir.path());
+
+    MainWindow w;
+    LatencyHarness harness(w);
+    for (const QString &f : files)
+        harness.runFile(QDir().absoluteFilePath(f), runs);
+    harness.runCountdown(runs);
+
+    QJsonObject report {
+        { "qtVersion", qVersion() },
+        { "platform", QGuiApplication::platformName() },
+        { "vo", parser.value(voOption) },
+        { "runs", runs },
+        { "results", harness.report() }
+    };
+    QByteArray json = QJsonDocument(report).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile f(parser.value(outputOption));
+        if (!f.open(QIODevice::WriteOnly)) {
+            QTextStream(stderr) << f.errorString() << "\n";
+            return 1;
+        }
+        f.write(json);
+    } else {
+        QTextStream(stdout) << json;
+    }
+    return 0;
+}
@@ -15,22 +15,185 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QLocalSocket>
+#include <QScreen>
+#include <QSettings>
+#include <QTimer>
+#include "controlserver.h"
+#include "kiosk.h"
 #include "mainwindow.h"
+#include "memorybudget.h"
+#include "trace.h"
+
+// Time from launch until the event loop is idle with the window or tray
+// icon up.  Going over it is logged as a warning.
+constexpr qint64 startupBudgetMsec = 500;
+
+static const char settingDisplayGeometry[] = "displayGeometry";
+
+// Parsed twice: once to forward to a running instance, once to start.
+struct CommandLine
+{
+    QCommandLineParser parser;
+    QCommandLineOption headless { "headless",
+            "Play a show bundle without the operator window.", "bundle" };
+    QCommandLineOption screen { "screen",
+            "Screen number to use for output in headless mode.", "n" };
+    QCommandLineOption show { "show", "Show a file on the output.", "file" };
+    QCommandLineOption countdown { "countdown",
+            "Start a countdown of the given length.", "seconds" };
+
+    CommandLine()
+    {
+        parser.setApplicationDescription("Countdown and media presenter");
+        parser.addHelpOption();
+        parser.addOptions({ headless, screen, show, countdown });
+        parser.addPositionalArgument("files", "Files to add to the playlist.");
+    }
+
+    // The actions asked for, in the control socket protocol.
+    QList<QByteArray> commands() const
+    {
+        QList<QByteArray> list;
+        for (const QString &file : parser.positionalArguments())
+            list.append("append " + QDir().absoluteFilePath(file).toUtf8());
+        if (parser.isSet(show))
+            list.append("show " + QDir().absoluteFilePath(parser.value(show)).toUtf8());
+        if (parser.isSet(countdown))
+            list.append("countdown " + parser.value(countdown).toUtf8());
+        return list;
+    }
+};
+
+// A second launch hands its command line to the running instance and
+// exits, rather than starting another mpv and fighting over the output.
+// It waits only for the replies that come at once, e.g. to append; show
+// and countdown are answered when their frame is painted, and their
+// replies are left to the running instance.
+static bool forwardToRunningInstance(const QCoreApplication &app)
+{
+    // Qt's own options such as -platform are not stripped here, so leave
+    // anything unusual to the normal start to report.
+    CommandLine cl;
+    if (!cl.parser.parse(app.arguments()) || cl.parser.isSet("help"))
+        return false;
+    QString name = ControlServer::configuredName();
+    if (cl.parser.isSet(cl.headless) || name.isEmpty())
+        return false;
+
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if (!socket.waitForConnected(250))
+        return false;
+    QList<QByteArray> commands = cl.commands();
+    if (commands.isEmpty())
+        commands.append("raise");
+    // Replies come in order, so only those before the first show or
+    // countdown can be waited for without waiting on a frame.
+    int immediate = 0;
+    for (int i = 0; i < commands.count(); i++) {
+        socket.write(commands[i] + '\n');
+        bool framed = commands[i].startsWith("show ")
+                || commands[i].startsWith("countdown ");
+        if (immediate == i && !framed)
+            immediate++;
+    }
+    socket.waitForBytesWritten(250);
+
+    QElapsedTimer clock;
+    clock.start();
+    int replies = 0;
+    while (replies < immediate && clock.elapsed() < 250
+           && socket.waitForReadyRead(250 - clock.elapsed())) {
+        while (replies < immediate && socket.canReadLine()) {
+            QByteArray reply = socket.readLine().trimmed();
+            if (reply.startsWith("error"))
+                qWarning().noquote() << commands[replies] << ":" << reply;
+            replies++;
+        }
+    }
+    return true;
+}
+
+static void reportStartup(const QElapsedTimer &startup)
+{
+    QTimer::singleShot(0, [&startup]() {
+        qint64 msec = startup.elapsed();
+        QString text = QString("Started in %1 ms, %2 MB resident")
+                .arg(msec).arg(MemoryBudget::residentBytes() / (1024 * 1024));
+        if (msec > startupBudgetMsec)
+            qWarning().noquote() << text << "- over the"
+                                 << startupBudgetMsec << "ms startup budget";
+        else
+            qInfo().noquote() << text;
+    });
+}
+
+// The screen given on the command line, else the one the operator window
+// last used for output, else the primary screen.
+static QRect outputGeometry(const QString &screenArg)
+{
+    auto screens = QGuiApplication::screens();
+    bool ok;
+    int index = screenArg.toInt(&ok);
+    if (ok && index >= 0 && index < screens.count())
+        return screens[index]->geometry();
+    QRect saved = QSettings().value(settingDisplayGeometry).toRect();
+    for (QScreen *screen : screens)
+        if (screen->geometry() == saved)
+            return saved;
+    return QGuiApplication::primaryScreen()->geometry();
+}
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer startup;
+    startup.start();
     QCoreApplication::setOrganizationName("PresenterDevs");
     QCoreApplication::setApplicationName("Presenter");
+    // Mirrored outputs draw the video texture rendered in another window.
+    QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    // The one application object, which is also used to forward to a
+    // running instance; Qt does not support creating a second one.
     QApplication a(argc, argv);
+    if (forwardToRunningInstance(a))
+        return 0;
 
     // mpv needs LC_NUMERIC set to the C locale
     setlocale(LC_NUMERIC, "C");
 
+    if (!qEnvironmentVariableIsEmpty("PRESENTER_TRACE"))
+        Trace::setRecording(true);
+
+    CommandLine cl;
+    cl.parser.process(a);
+
     a.setQuitOnLastWindowClosed(false);
+
+    if (cl.parser.isSet(cl.headless)) {
+        Kiosk kiosk;
+        if (!kiosk.open(cl.parser.value(cl.headless))) {
+            qCritical().noquote() << QString("Could not open %1: %2")
+                                     .arg(cl.parser.value(cl.headless),
+                                          kiosk.errorString());
+            return 1;
+        }
+        kiosk.setGeometry(outputGeometry(cl.parser.value(cl.screen)));
+        kiosk.start();
+        reportStartup(startup);
+        return a.exec();
+    }
+
     MainWindow w;
     if (w.startMinimized())
         w.showMinimized();
     else if (w.startVisible())
         w.show();
+    w.runCommands(cl.commands());
+    reportStartup(startup);
     return a.exec();
 }
@@ -15,34 +15,147 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <algorithm>
 #include <QApplication>
+#include <QDebug>
 #include <QDesktopWidget>
 #include <QDragMoveEvent>
+#include <QElapsedTimer>
 #include <QFileDialog>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QLabel>
 #include <QMenu>
 #include <QMimeData>
 #include <QMessageBox>
 #include <QPaintEvent>
+#include <QProgressDialog>
 #include <QScreen>
+#include <QSignalBlocker>
+#include <QStandardPaths>
+#include <QThread>
 #include <QTimer>
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "timedialog.h"
+#include "trace.h"
+
+static constexpr int dwellRole = Qt::UserRole;
+static constexpr int storeIdRole = Qt::UserRole + 1;
+
+static const char journalFilename[] = "/show.journal";
+
+// Stingers are named by their setting.
+static const char settingStingerMinute[] = "stingerCountdownMinute";
+static const char settingStingerZero[] = "stingerCountdownZero";
+static const char settingStingerCue[] = "stingerCueGo";
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    store(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+          + journalFilename),
+    slideshow(&displayWidget),
+    cueList(&displayWidget, &standbyWidget),
+    control({ &displayWidget, &standbyWidget })
 {
+    TRACE_SPAN("MainWindow");
     ui->setupUi(this);
     setAcceptDrops(true);
-    setupPreview();
+    ui->actionDiagnosticsTrace->setChecked(Trace::recording);
+    connect(&slideshow, &Slideshow::statsChanged, this, [this]() {
+        ui->slideshowStats->setText(slideshow.statsText());
+    });
+    connect(&slideshow, &Slideshow::itemShown, this, [this](int index) {
+        ui->imagesList->setCurrentRow(index);
+    });
+    connect(&cueList, &CueList::cueStarted, this, [this](int index) {
+        ui->cueList->setCurrentRow(index);
+        stingers.play(settingStingerCue);
+    });
+    for (DisplayWidget *d : { &displayWidget, &standbyWidget }) {
+        connect(d, &DisplayWidget::countdownStarted,
+                this, [this,d](const QDateTime &endTime) {
+            scheduleStinger(d, endTime, 60000, settingStingerMinute);
+            scheduleStinger(d, endTime, 0, settingStingerZero);
+        });
+    }
+    connect(&control, &ControlServer::countdownRequested,
+            this, &MainWindow::startCountdown);
+    connect(&control, &ControlServer::countdownPartwayRequested,
+            this, &MainWindow::startCountdownPartway);
+    connect(&control, &ControlServer::imageRequested,
+            this, &MainWindow::startImage);
+    connect(&control, &ControlServer::stepRequested,
+            this, &MainWindow::stepItem);
+    connect(&control, &ControlServer::itemRequested,
+            this, &MainWindow::startItem);
+    connect(&control, &ControlServer::stopRequested,
+            this, &MainWindow::stopOutput);
+    connect(&control, &ControlServer::appendRequested,
+            this, [this](const QString &filename) { appendImages({filename}); });
+    connect(&control, &ControlServer::textRequested,
+            this, [this](int block, const QString &text) {
+        setOverlayText(TextOverlay::Block(block), text);
+    });
+    connect(&control, &ControlServer::clockRequested,
+            ui->actionShowClock, &QAction::setChecked);
+    connect(&control, &ControlServer::raiseRequested, this, [this]() {
+        showNormal();
+        raise();
+        activateWindow();
+    });
+    connect(ui->imagesList->model(), &QAbstractItemModel::rowsMoved,
+            this, &MainWindow::saveImageOrder);
+    connect(&mediaCache, &MediaCache::progress,
+            this, [this](qint64 done, qint64 total) {
+        ui->imagesStageProgress->setValue(total > 0 ? done * 1000 / total : 1000);
+    });
+    lagLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(lagLabel);
+    connect(&watchdog, &Watchdog::statsChanged, this, [this]() {
+        lagLabel->setText(watchdog.statsText());
+    });
+    memoryLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(memoryLabel);
+    connect(MemoryBudget::instance(), &MemoryBudget::statsChanged, this, [this]() {
+        MemoryBudget *budget = MemoryBudget::instance();
+        memoryLabel->setText(budget->statsText());
+        memoryLabel->setToolTip(budget->detailText());
+    });
+    exportLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(exportLabel);
+    connect(&frameExport, &FrameExport::statsChanged, this, [this]() {
+        exportLabel->setText(frameExport.statsText());
+    });
+    streamLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(streamLabel);
+    for (DisplayWidget *d : { &displayWidget, &standbyWidget }) {
+        connect(d, &DisplayWidget::streamStatsChanged, this, [this,d]() {
+            streamLabel->setText(d->streamStatsText());
+        });
+    }
+    stingerLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(stingerLabel);
+    connect(&stingers, &AudioStingers::played,
+            this, [this](const QString &name, double msecLatency) {
+        qInfo().noquote() << QString("Stinger %1 played after %2 ms")
+                             .arg(name).arg(msecLatency, 0, 'f', 1);
+        stingerLabel->setText(stingers.statsText());
+    });
     setupTrayIcon();
     setupScreens();
     restoreSettings();
+    watchdog.start(QThread::HighPriority);
+    stingers.start(QThread::TimeCriticalPriority);
 }
 
 MainWindow::~MainWindow()
 {
+    if (renderThread) {
+        renderCancelled = true;
+        renderThread->wait();
+    }
     saveSettings();
     delete ui;
 }
@@ -57,6 +170,13 @@ bool MainWindow::startVisible()
     return !ui->programSystemTray->isChecked();
 }
 
+// Commands in the control socket protocol, e.g. from the command line.
+void MainWindow::runCommands(const QList<QByteArray> &commands)
+{
+    for (const QByteArray &command : commands)
+        control.execute(command);
+}
+
 static const char settingDisplayGeometry[] = "displayGeometry";
 static const char settingStartMinimized[] = "startMinimized";
 static const char settingSystemTray[] = "systemTray";
@@ -64,48 +184,118 @@ static const char settingWarnOnClose[] = "warnOnClose";
 static const char settingCountdowns[] = "Countdowns";
 static const char settingImages[] = "Images";
 static const char settingFilename[] = "filename";
+static const char settingDwell[] = "dwell";
+static const char settingSlideshowDwell[] = "slideshowDwell";
+static const char settingSlideshowLoop[] = "slideshowLoop";
+static const char settingSlideshowCrossfade[] = "slideshowCrossfade";
+static const char settingStageMedia[] = "stageMedia";
+static const char settingStageLimit[] = "stageLimit";
+static const char settingStageDirectory[] = "stageDirectory";
+static const char settingStallThreshold[] = "stallThreshold";
+static const char settingMemoryBudget[] = "memoryBudget";
+static const char settingCountdownBackground[] = "countdownBackground";
+static const char settingMirrorGeometries[] = "mirrorGeometries";
+static const char settingSpanOutputs[] = "spanOutputs";
+static const char settingSpanBezel[] = "spanBezel";
+static const char settingShareFrames[] = "shareFrames";
+static const char settingShareFramesName[] = "shareFramesName";
+static const char settingShareFramesDepth[] = "shareFramesDepth";
+static const char settingRenderFps[] = "renderFps";
+static const char settingStreamCache[] = "streamCache";
+static const char settingStreamReadahead[] = "streamReadahead";
+static const char settingStreamPrebuffer[] = "streamPrebuffer";
+static const char settingZoneLayout[] = "zoneLayout";
 
 void MainWindow::restoreSettings()
 {
+    TRACE_SPAN("restoreSettings");
     int index;
     int size;
-    QStringList files;
 
     usedDisplayGeometry = settings.value(settingDisplayGeometry, QRect()).toRect();
     index = screenAreas.indexOf(usedDisplayGeometry);
     if (index >= 0)
         ui->monitorCombo->setCurrentIndex(index);
+    for (const QVariant &v : settings.value(settingMirrorGeometries).toList())
+        mirrorGeometries.append(v.toRect());
+    spanOutputs = settings.value(settingSpanOutputs, false).toBool();
+    spanBezel = settings.value(settingSpanBezel, 0).toInt();
+    populateMirrorMenu();
+    updateMirrors();
 
     ui->programSystemTray->setChecked(settings.value(settingSystemTray, false).toBool());
     ui->programStartMinimized->setChecked(settings.value(settingStartMinimized, false).toBool());
     ui->programWarnOnClose->setChecked(settings.value(settingWarnOnClose, true).toBool());
+    ui->slideshowDwell->setValue(settings.value(settingSlideshowDwell, 5).toInt());
+    ui->slideshowLoop->setChecked(settings.value(settingSlideshowLoop, true).toBool());
+    ui->slideshowCrossfade->setChecked(settings.value(settingSlideshowCrossfade, true).toBool());
+    ui->imagesStageLimit->setValue(settings.value(settingStageLimit, 20).toInt());
+    setCountdownBackground(settings.value(settingCountdownBackground).toString());
+    QString layoutError;
+    QString layoutPath = settings.value(settingZoneLayout).toString();
+    if (!setZoneLayout(layoutPath, &layoutError))
+        qWarning().noquote() << QString("Zone layout %1 unusable: %2")
+                                .arg(layoutPath, layoutError);
+    // Point this at a tmpfs such as /dev/shm for a RAM-backed store.
+    mediaCache.setDirectory(settings.value(settingStageDirectory,
+                                           mediaCache.directory()).toString());
+    watchdog.setThreshold(settings.value(settingStallThreshold, 250).toInt());
+    // In megabytes; 0 leaves memory unbounded.
+    MemoryBudget::instance()->setBudget(
+                settings.value(settingMemoryBudget, 0).toLongLong() * 1024 * 1024);
+    // Cache in megabytes, readahead and pre-buffer in seconds.
+    streamCache.bytes = settings.value(settingStreamCache,
+                                       streamCache.bytes / (1024 * 1024))
+            .toLongLong() * 1024 * 1024;
+    streamCache.readaheadSecs = settings.value(settingStreamReadahead,
+                                               streamCache.readaheadSecs).toDouble();
+    streamCache.prebufferSecs = settings.value(settingStreamPrebuffer,
+                                               streamCache.prebufferSecs).toDouble();
+    displayWidget.setStreamCache(streamCache);
+    standbyWidget.setStreamCache(streamCache);
+    // WAV files; "chime" is a built-in chime, and empty is silence.
+    loadStinger(settingStingerMinute, "chime", 660);
+    loadStinger(settingStingerZero, "chime", 880);
+    loadStinger(settingStingerCue, QString(), 990);
+    QString controlName = ControlServer::configuredName();
+    if (!controlName.isEmpty() && !control.listen(controlName))
+        qWarning().noquote() << QString("Control socket %1 unavailable: %2")
+                                .arg(controlName, control.errorString());
 
-    size = settings.beginReadArray(settingCountdowns);
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        QSharedPointer<Countdown> c(new Countdown);
-        c->readSettings(settings);
-        c->updateTimer();
-        auto cData = c.data();
-        connect(c->timer.data(), &QTimer::timeout,
-                cData, [this,cData]() {
-            startCountdown(cData->duration.msecsSinceStartOfDay());
-            cData->updateTimer();
-            cData->timer->start();
-        });
-        c->timer->start();
-        appendCountdown(c);
-    }
-    settings.endArray();
+    // Countdowns and images used to be saved as settings arrays; move them
+    // into the journal the first time it is created.
+    bool migrate = !store.exists();
+    store.load();
+    for (auto c : store.countdowns())
+        scheduleCountdown(c);
+    for (auto &image : store.images())
+        appendImage(image.filename, image.dwellSeconds, image.id);
+    for (const Cue &cue : store.cues())
+        appendCue(cue);
+
+    if (migrate) {
+        size = settings.beginReadArray(settingCountdowns);
+        for (int i = 0; i < size; ++i) {
+            settings.setArrayIndex(i);
+            QSharedPointer<Countdown> c(new Countdown);
+            c->readSettings(settings);
+            c->storeId = store.putCountdown(*c);
+            scheduleCountdown(c);
+        }
+        settings.endArray();
 
-    size = settings.beginReadArray(settingImages);
-    files.clear();
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        files.append(settings.value(settingFilename).toString());
+        size = settings.beginReadArray(settingImages);
+        for (int i = 0; i < size; ++i) {
+            settings.setArrayIndex(i);
+            appendImage(settings.value(settingFilename).toString(),
+                        settings.value(settingDwell, 0).toInt());
+        }
+        settings.endArray();
+        settings.remove(settingCountdowns);
+        settings.remove(settingImages);
     }
-    settings.endArray();
-    appendImages(files);
+    ui->imagesStage->setChecked(settings.value(settingStageMedia, false).toBool());
+    ui->actionShowShareFrames->setChecked(settings.value(settingShareFrames, false).toBool());
 
     // update things
     on_programSystemTray_clicked();
@@ -113,32 +303,39 @@ void MainWindow::restoreSettings()
 
 void MainWindow::saveSettings()
 {
-    int size;
-
+    TRACE_SPAN("saveSettings");
     settings.setValue(settingDisplayGeometry, usedDisplayGeometry);
+    QVariantList mirrorList;
+    for (const QRect &g : mirrorGeometries)
+        mirrorList.append(g);
+    settings.setValue(settingMirrorGeometries, mirrorList);
+    settings.setValue(settingSpanOutputs, spanOutputs);
+    settings.setValue(settingSpanBezel, spanBezel);
+    settings.setValue(settingShareFrames, ui->actionShowShareFrames->isChecked());
     settings.setValue(settingStartMinimized, ui->programStartMinimized->isChecked());
     settings.setValue(settingSystemTray, ui->programSystemTray->isChecked());
     settings.setValue(settingWarnOnClose, ui->programWarnOnClose->isChecked());
-
-    size = countdowns.size();
-    settings.beginWriteArray(settingCountdowns);
-    for (int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        countdowns[i]->writeSettings(settings);
-    }
-    settings.endArray();
-
-    size = ui->imagesList->count();
-    settings.beginWriteArray(settingImages);
-    for (int i = 0; i < size; ++i) {
-       settings.setArrayIndex(i);
-       settings.setValue(settingFilename, ui->imagesList->item(i)->text());
-    }
-    settings.endArray();
+    settings.setValue(settingSlideshowDwell, ui->slideshowDwell->value());
+    settings.setValue(settingSlideshowLoop, ui->slideshowLoop->isChecked());
+    settings.setValue(settingSlideshowCrossfade, ui->slideshowCrossfade->isChecked());
+    settings.setValue(settingStageMedia, ui->imagesStage->isChecked());
+    settings.setValue(settingStageLimit, ui->imagesStageLimit->value());
+    settings.setValue(settingCountdownBackground, countdownBackground);
+    settings.setValue(settingZoneLayout, zoneLayoutPath);
+    settings.setValue(settingStageDirectory, mediaCache.directory());
+    settings.setValue(settingStallThreshold, watchdog.threshold());
+    settings.setValue(settingMemoryBudget,
+                      MemoryBudget::instance()->budget() / (1024 * 1024));
+    settings.setValue(settingStreamCache, streamCache.bytes / (1024 * 1024));
+    settings.setValue(settingStreamReadahead, streamCache.readaheadSecs);
+    settings.setValue(settingStreamPrebuffer, streamCache.prebufferSecs);
+    for (auto i = stingerFiles.constBegin(); i != stingerFiles.constEnd(); ++i)
+        settings.setValue(i.key(), i.value());
 }
 
 void MainWindow::populateScreens()
 {
+    TRACE_SPAN("populateScreens");
     ui->monitorCombo->clear();
     screenAreas.clear();
     auto screens = QGuiApplication::screens();
@@ -154,6 +351,50 @@ void MainWindow::populateScreens()
         if (g == usedDisplayGeometry)
             ui->monitorCombo->setCurrentIndex(i);
     }
+    populateMirrorMenu();
+    updateMirrors();
+}
+
+void MainWindow::populateMirrorMenu()
+{
+    QMenu *menu = ui->monitorMirror->menu();
+    if (!menu) {
+        menu = new QMenu(ui->monitorMirror);
+        ui->monitorMirror->setMenu(menu);
+    }
+    menu->clear();
+    for (int i = 0; i < screenAreas.count(); i++) {
+        QRect g = screenAreas[i];
+        QAction *mirror = menu->addAction(ui->monitorCombo->itemText(i));
+        mirror->setCheckable(true);
+        mirror->setChecked(mirrorGeometries.contains(g));
+        connect(mirror, &QAction::toggled, this, [this,g](bool checked) {
+            mirrorGeometries.removeAll(g);
+            if (checked)
+                mirrorGeometries.append(g);
+            updateMirrors();
+        });
+    }
+    menu->addSeparator();
+    QAction *span = menu->addAction(tr("Span as one canvas"));
+    span->setCheckable(true);
+    span->setChecked(spanOutputs);
+    connect(span, &QAction::toggled, this, [this](bool checked) {
+        spanOutputs = checked;
+        updateMirrors();
+    });
+    QAction *bezel = menu->addAction(tr("Bezel..."));
+    connect(bezel, &QAction::triggered, this, [this]() {
+        bool ok;
+        int pixels = QInputDialog::getInt(this, tr("Bezel - Presenter"),
+            tr("Pixels hidden between neighbouring screens\n"
+               "(negative where projectors overlap):"),
+            spanBezel, -4096, 4096, 1, &ok);
+        if (!ok)
+            return;
+        spanBezel = pixels;
+        updateMirrors();
+    });
 }
 
 void MainWindow::closeEvent(QCloseEvent *event)
@@ -173,6 +414,23 @@ void MainWindow::closeEvent(QCloseEvent *event)
         qApp->quit();
 }
 
+// The preview is built the first time the window is shown other than
+// minimized, so a start to the tray or to the task bar does not create it.
+void MainWindow::showEvent(QShowEvent *event)
+{
+    if (!imagesPreview && !isMinimized())
+        setupPreview();
+    QMainWindow::showEvent(event);
+}
+
+void MainWindow::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::WindowStateChange && !imagesPreview
+            && isVisible() && !isMinimized())
+        setupPreview();
+    QMainWindow::changeEvent(event);
+}
+
 void MainWindow::dragMoveEvent(QDragMoveEvent *event)
 {
     if (event->mimeData()->hasUrls() && event->answerRect().intersects(ui->imagesList->geometry())) {
@@ -204,8 +462,11 @@ void MainWindow::dropEvent(QDropEvent *event)
 
 void MainWindow::setupPreview()
 {
+    TRACE_SPAN("setupPreview");
     imagesPreview = new DisplayWidget(nullptr, true);
     ui->imagesPreviewFrame->layout()->addWidget(imagesPreview);
+    if (ui->imagesList->currentItem())
+        on_imagesList_currentTextChanged(ui->imagesList->currentItem()->text());
 }
 
 
@@ -246,6 +507,68 @@ void MainWindow::useDisplayGeometry()
     if (!screenAreas.contains(usedDisplayGeometry))
         usedDisplayGeometry = screenAreas[ui->monitorCombo->currentIndex()];
     displayWidget.setGeometry(usedDisplayGeometry);
+    standbyWidget.setGeometry(usedDisplayGeometry);
+    prepareZoneStills();
+    emit displayGeometryApplied();
+}
+
+// Places screens on one canvas by their desktop positions, with bezel
+// pixels hidden between neighbouring rows and columns.
+static QList<QRect> wallTiles(const QList<QRect> &screens, int bezel, QSize &canvas)
+{
+    QRect bounds;
+    QList<int> columns;
+    QList<int> rows;
+    for (const QRect &g : screens) {
+        bounds |= g;
+        if (!columns.contains(g.left()))
+            columns.append(g.left());
+        if (!rows.contains(g.top()))
+            rows.append(g.top());
+    }
+    std::sort(columns.begin(), columns.end());
+    std::sort(rows.begin(), rows.end());
+
+    QList<QRect> tiles;
+    for (const QRect &g : screens) {
+        QPoint gaps(columns.indexOf(g.left()) * bezel, rows.indexOf(g.top()) * bezel);
+        tiles.append(g.translated(gaps - bounds.topLeft()));
+    }
+    canvas = bounds.size() + QSize((columns.count() - 1) * bezel,
+                                   (rows.count() - 1) * bezel);
+    return tiles;
+}
+
+// Mirrored screens show the output screen's content from the same decode,
+// either whole or, when spanning, as their tile of one canvas.  Cues taken
+// on the standby output take the mirrors with them.
+void MainWindow::updateMirrors()
+{
+    mirrorOutputs.clear();
+    QList<QRect> screens { usedDisplayGeometry };
+    for (const QRect &g : mirrorGeometries) {
+        if (!screenAreas.contains(g) || screens.contains(g))
+            continue;
+        QSharedPointer<DisplayWidget> mirror(new DisplayWidget);
+        mirror->setGeometry(g);
+        cueList.output()->addMirror(mirror.data());
+        mirrorOutputs.append(mirror);
+        screens.append(g);
+    }
+
+    if (!spanOutputs || mirrorOutputs.isEmpty()) {
+        displayWidget.setTile(QSize(), QRect());
+        standbyWidget.setTile(QSize(), QRect());
+        prepareZoneStills();
+        return;
+    }
+    QSize canvas;
+    QList<QRect> tiles = wallTiles(screens, spanBezel, canvas);
+    displayWidget.setTile(canvas, tiles[0]);
+    standbyWidget.setTile(canvas, tiles[0]);
+    for (int i = 0; i < mirrorOutputs.count(); i++)
+        mirrorOutputs[i]->setTile(canvas, tiles[i + 1]);
+    prepareZoneStills();
 }
 
 void MainWindow::appendCountdown(QSharedPointer<Countdown> c)
@@ -254,28 +577,237 @@ void MainWindow::appendCountdown(QSharedPointer<Countdown> c)
     countdowns.append(c);
 }
 
+void MainWindow::scheduleCountdown(QSharedPointer<Countdown> c)
+{
+    c->updateTimer();
+    Countdown *cData = c.data();
+    connect(c->timer.data(), &QTimer::timeout,
+            cData, [this,cData]() {
+        startCountdown(cData->duration.msecsSinceStartOfDay());
+        cData->updateTimer();
+        cData->timer->start();
+    });
+    c->timer->start();
+    appendCountdown(c);
+}
+
+void MainWindow::setCountdownBackground(const QString &filename)
+{
+    countdownBackground = filename;
+    displayWidget.setCountdownBackground(filename);
+    standbyWidget.setCountdownBackground(filename);
+    ui->countdownBackgroundName->setText(filename.isEmpty()
+            ? tr("None") : QFileInfo(filename).fileName());
+    ui->countdownBackgroundName->setToolTip(filename);
+}
+
+// An empty path goes back to showing everything full screen.
+bool MainWindow::setZoneLayout(const QString &path, QString *error)
+{
+    ZoneLayout layout;
+    if (!path.isEmpty() && !layout.load(path, error))
+        return false;
+    zoneLayoutPath = path;
+    zoneLayout = layout;
+    zoneStillsSize = QSize();
+    zoneStillMemory.set(0);
+    displayWidget.setZoneLayout(layout);
+    standbyWidget.setZoneLayout(layout);
+    if (!screenAreas.isEmpty())
+        useDisplayGeometry();
+    prepareZoneStills();
+    return true;
+}
+
+// Stills are decoded on the workers at their zone's size, and again
+// whenever the output or span canvas changes size.  Until they arrive the
+// zones keep the stills they had, if any.
+void MainWindow::prepareZoneStills()
+{
+    QSize size = displayWidget.outputSize();
+    if (size == zoneStillsSize)
+        return;
+    zoneStillsSize = size;
+    for (JobScheduler::Handle &job : zoneStillJobs)
+        job.cancel();
+    zoneStillJobs.clear();
+    QRect area(QPoint(), size);
+    for (int i = 0; i < zoneLayout.zones.count(); i++) {
+        const ZoneLayout::Zone &z = zoneLayout.zones[i];
+        if (z.kind != ZoneLayout::Still)
+            continue;
+        QString filename = z.filename;
+        zoneStillJobs.append(DisplayWidget::prepareImageJob(JobScheduler::NextUp,
+                filename, ZoneLayout::map(z.area, area).size(), this,
+                [this, i, filename](const QImage &image) {
+            if (image.isNull())
+                qWarning().noquote() << QString("Zone still %1 could not be read")
+                                        .arg(filename);
+            displayWidget.setZoneImage(i, image);
+            standbyWidget.setZoneImage(i, image);
+            // Both outputs share the one image; it is counted here once.
+            zoneLayout.zones[i].image = image;
+            qint64 bytes = 0;
+            for (const ZoneLayout::Zone &zone : qAsConst(zoneLayout.zones))
+                bytes += zone.image.sizeInBytes();
+            zoneStillMemory.set(bytes);
+        }));
+    }
+}
+
+void MainWindow::loadStinger(const char *setting, const QString &defaultFile,
+                             double chimeFrequency)
+{
+    QString file = settings.value(setting, defaultFile).toString();
+    stingerFiles.insert(setting, file);
+    QString error;
+    if (file == "chime")
+        stingers.loadChime(setting, chimeFrequency, 900);
+    else if (!file.isEmpty() && !stingers.load(setting, file, &error))
+        qWarning().noquote() << QString("Stinger %1 unusable: %2").arg(file, error);
+}
+
+// Played only if the same countdown is still on air when the time comes.
+void MainWindow::scheduleStinger(DisplayWidget *output, const QDateTime &endTime,
+                                 qint64 msecBefore, const char *setting)
+{
+    qint64 msec = QDateTime::currentDateTime().msecsTo(endTime) - msecBefore;
+    if (msec < 0 || !stingers.contains(setting))
+        return;
+    QTimer::singleShot(int(msec), Qt::PreciseTimer, this, [this, output, endTime, setting]() {
+        if (output->countdownEnd() == endTime)
+            stingers.play(setting);
+    });
+}
+
 void MainWindow::appendImages(const QStringList &images)
 {
     for (auto filename : images)
-        ui->imagesList->addItem(filename);
+        appendImage(filename);
+    stageImages();
+}
+
+// Images without a store id are new and get journaled as they are added.
+void MainWindow::appendImage(const QString &filename, int dwellSeconds, quint32 id)
+{
+    if (!id)
+        id = store.putImage(0, filename, dwellSeconds);
+    auto item = new QListWidgetItem(filename);
+    item->setData(dwellRole, dwellSeconds);
+    item->setData(storeIdRole, id);
+    ui->imagesList->addItem(item);
+}
+
+// Cues without a store id are new and get journaled as they are added.
+void MainWindow::appendCue(Cue cue)
+{
+    if (!cue.storeId)
+        cue.storeId = store.putCue(cue);
+    auto item = new QListWidgetItem(cue.toString());
+    item->setData(storeIdRole, cue.storeId);
+    ui->cueList->addItem(item);
+    cues.append(cue);
+    updateCues();
+}
+
+void MainWindow::updateCues()
+{
+    QList<Cue> playable = cues;
+    for (Cue &cue : playable)
+        if (cue.kind != Cue::CountdownCue)
+            cue.filename = mediaCache.localPath(cue.filename);
+    cueList.setCues(playable);
+}
+
+void MainWindow::saveImageOrder()
+{
+    QList<quint32> ids;
+    for (int i = 0; i < ui->imagesList->count(); i++)
+        ids.append(ui->imagesList->item(i)->data(storeIdRole).toUInt());
+    store.setImageOrder(ids);
+}
+
+QStringList MainWindow::imageFiles() const
+{
+    QStringList files;
+    for (int i = 0; i < ui->imagesList->count(); i++)
+        files.append(ui->imagesList->item(i)->text());
+    return files;
+}
+
+void MainWindow::stageImages()
+{
+    if (ui->imagesStage->isChecked())
+        mediaCache.stage(imageFiles());
 }
 
 void MainWindow::startCountdown(int msecDuration)
 {
+    slideshow.stop();
+    cueList.stop();
     useDisplayGeometry();
     displayWidget.startCountdown(msecDuration);
 }
 
 void MainWindow::startCountdownPartway(int msecsPosition, int msecsDuration)
 {
+    slideshow.stop();
+    cueList.stop();
     useDisplayGeometry();
     displayWidget.startCountdownPartway(msecsPosition, msecsDuration);
 }
 
 void MainWindow::startImage(const QString &filename)
 {
+    slideshow.stop();
+    cueList.stop();
     useDisplayGeometry();
-    displayWidget.displayFile(filename);
+    QImage frame;
+    if (bundle.matches(usedDisplayGeometry.size()))
+        frame = bundle.frame(filename);
+    if (!frame.isNull())
+        displayWidget.displayImage(frame, false);
+    else
+        displayWidget.displayFile(mediaCache.localPath(filename));
+}
+
+void MainWindow::startItem(int index)
+{
+    if (index < 0 || index >= ui->imagesList->count()) {
+        control.reject("bad arguments");
+        return;
+    }
+    ui->imagesList->setCurrentRow(index);
+    startImage(ui->imagesList->item(index)->text());
+}
+
+void MainWindow::stepItem(int delta)
+{
+    int count = ui->imagesList->count();
+    if (count == 0) {
+        control.reject("empty playlist");
+        return;
+    }
+    int index = ui->imagesList->currentRow() + delta;
+    startItem((index % count + count) % count);
+}
+
+void MainWindow::stopOutput()
+{
+    if (!cueList.output()->isShown())
+        control.ignore();
+    slideshow.stop();
+    if (cueList.isRunning())
+        cueList.stop();
+    else
+        displayWidget.stop();
+}
+
+// Both outputs carry the same text, so that it stays up across cues.
+void MainWindow::setOverlayText(TextOverlay::Block block, const QString &text)
+{
+    displayWidget.setOverlayText(block, text);
+    standbyWidget.setOverlayText(block, text);
 }
 
 void MainWindow::on_countdownAdd_clicked()
@@ -286,15 +818,8 @@ void MainWindow::on_countdownAdd_clicked()
     if(d.exec() == QDialog::Rejected)
         return;
     d.updateCountdown();
-    Countdown *cData = c.data();
-    connect(c->timer.data(), &QTimer::timeout,
-            cData, [this,cData]() {
-        startCountdown(cData->duration.msecsSinceStartOfDay());
-        cData->updateTimer();
-        cData->timer->start();
-    });
-    c->timer->start();
-    appendCountdown(c);
+    c->storeId = store.putCountdown(*c);
+    scheduleCountdown(c);
 }
 
 void MainWindow::on_countdownRemove_clicked()
@@ -303,6 +828,7 @@ void MainWindow::on_countdownRemove_clicked()
     if (i < 0)
         return;
     delete ui->countdownList->takeItem(i);
+    store.remove(countdowns[i]->storeId);
     countdowns.removeAt(i);
 }
 
@@ -310,6 +836,7 @@ void MainWindow::on_countdownClear_clicked()
 {
     ui->countdownList->clear();
     countdowns.clear();
+    store.clearCountdowns();
 }
 
 void MainWindow::on_countdownTest_clicked()
@@ -330,7 +857,7 @@ void MainWindow::on_countdownStart_clicked()
 
 void MainWindow::on_countdownStop_clicked()
 {
-    displayWidget.stop();
+    stopOutput();
 }
 
 void MainWindow::on_countdownList_itemDoubleClicked(QListWidgetItem *item)
@@ -344,9 +871,17 @@ void MainWindow::on_countdownList_itemDoubleClicked(QListWidgetItem *item)
     if(d.exec() == QDialog::Rejected)
         return;
     d.updateCountdown();
+    store.putCountdown(*countdowns[i]);
     item->setText(countdowns[i]->toString());
 }
 
+// Cancelling the file dialog goes back to a black background.
+void MainWindow::on_countdownBackground_clicked()
+{
+    setCountdownBackground(QFileDialog::getOpenFileName(this, tr("Countdown background"),
+        QString(), "Videos (*.mp4 *.mkv *.avi *.m4v);;All files (*.*)"));
+}
+
 void MainWindow::on_imagesAdd_clicked()
 {
     QStringList files = QFileDialog::getOpenFileNames(this, QString(), QString(),
@@ -357,13 +892,16 @@ void MainWindow::on_imagesAdd_clicked()
 void MainWindow::on_imagesRemove_clicked()
 {
     auto selected = ui->imagesList->selectedItems();
-    for (auto i : selected)
+    for (auto i : selected) {
+        store.remove(i->data(storeIdRole).toUInt());
         delete i;
+    }
 }
 
 void MainWindow::on_imagesClear_clicked()
 {
     ui->imagesList->clear();
+    store.clearImages();
 }
 
 void MainWindow::on_imagesShow_clicked()
@@ -376,7 +914,7 @@ void MainWindow::on_imagesShow_clicked()
 
 void MainWindow::on_imagesHide_clicked()
 {
-    displayWidget.stop();
+    stopOutput();
 }
 
 void MainWindow::on_imagesList_itemDoubleClicked(QListWidgetItem *item)
@@ -386,7 +924,201 @@ void MainWindow::on_imagesList_itemDoubleClicked(QListWidgetItem *item)
 
 void MainWindow::on_imagesList_currentTextChanged(const QString &currentText)
 {
-    imagesPreview->displayFile(currentText);
+    // Selecting a video is a good hint that it is about to be shown.
+    if (DisplayWidget::isMediaFile(currentText))
+        displayWidget.prepareVideo();
+    if (!imagesPreview)
+        return;
+    // Rows already scrolled past are not worth decoding.
+    previewJob.cancel();
+    QString filename = mediaCache.localPath(currentText);
+    if (DisplayWidget::isMediaFile(filename)) {
+        imagesPreview->displayFile(filename);
+        return;
+    }
+    QSize size = imagesPreview->contentSize() * imagesPreview->devicePixelRatioF();
+    previewJob = DisplayWidget::prepareImageJob(JobScheduler::Preview, filename, size,
+                                                imagesPreview, [this](const QImage &image) {
+        imagesPreview->displayImage(image, false);
+    });
+}
+
+void MainWindow::on_imagesStage_toggled(bool checked)
+{
+    if (checked) {
+        on_imagesStageLimit_valueChanged(ui->imagesStageLimit->value());
+        stageImages();
+    } else {
+        mediaCache.cancel();
+    }
+}
+
+void MainWindow::on_imagesStageLimit_valueChanged(int value)
+{
+    mediaCache.setBandwidthLimit(qint64(value) * 1024 * 1024);
+}
+
+void MainWindow::on_slideshowItemDwell_clicked()
+{
+    auto selected = ui->imagesList->selectedItems();
+    if (selected.isEmpty())
+        return;
+    bool ok;
+    int seconds = QInputDialog::getInt(this, tr("Item dwell - Presenter"),
+                                       tr("Seconds (0 uses the slideshow dwell):"),
+                                       selected[0]->data(dwellRole).toInt(),
+                                       0, 86400, 1, &ok);
+    if (!ok)
+        return;
+    for (auto i : selected) {
+        i->setData(dwellRole, seconds);
+        store.putImage(i->data(storeIdRole).toUInt(), i->text(), seconds);
+    }
+}
+
+void MainWindow::on_slideshowStart_clicked()
+{
+    cueList.stop();
+    useDisplayGeometry();
+    bool useBundle = bundle.matches(usedDisplayGeometry.size());
+    QList<Slideshow::Item> items;
+    for (int i = 0; i < ui->imagesList->count(); i++) {
+        auto item = ui->imagesList->item(i);
+        items.append({ mediaCache.localPath(item->text()),
+                       item->data(dwellRole).toInt() * 1000,
+                       useBundle ? bundle.frame(item->text()) : QImage() });
+    }
+    if (items.isEmpty())
+        return;
+    slideshow.setItems(items);
+    slideshow.setDwell(ui->slideshowDwell->value() * 1000);
+    slideshow.setLoop(ui->slideshowLoop->isChecked());
+    slideshow.setCrossfade(ui->slideshowCrossfade->isChecked());
+    slideshow.start(ui->imagesList->currentRow());
+}
+
+void MainWindow::on_cueAddCountdown_clicked()
+{
+    bool ok;
+    int minutes = QInputDialog::getInt(this, tr("Add countdown cue"),
+                                       tr("Minutes:"), 5, 1, 24 * 60, 1, &ok);
+    if (!ok)
+        return;
+    Cue cue;
+    cue.kind = Cue::CountdownCue;
+    cue.msecDuration = minutes * 60000;
+    appendCue(cue);
+}
+
+void MainWindow::on_cueAddFiles_clicked()
+{
+    QStringList files = QFileDialog::getOpenFileNames(this, tr("Add cues"));
+    for (const QString &filename : files) {
+        Cue cue;
+        cue.kind = DisplayWidget::isMediaFile(filename) ? Cue::VideoCue
+                                                        : Cue::StillCue;
+        cue.filename = filename;
+        appendCue(cue);
+    }
+}
+
+void MainWindow::on_cueRemove_clicked()
+{
+    int i = ui->cueList->currentRow();
+    if (i < 0)
+        return;
+    delete ui->cueList->takeItem(i);
+    store.remove(cues[i].storeId);
+    cues.removeAt(i);
+    updateCues();
+}
+
+void MainWindow::on_cueClear_clicked()
+{
+    cueList.stop();
+    ui->cueList->clear();
+    cues.clear();
+    store.clearCues();
+    updateCues();
+}
+
+void MainWindow::on_cueBack_clicked()
+{
+    cueList.back();
+}
+
+void MainWindow::on_cueGo_clicked()
+{
+    slideshow.stop();
+    useDisplayGeometry();
+    if (cueList.isRunning())
+        cueList.go();
+    else
+        cueList.goTo(std::max(ui->cueList->currentRow(), 0));
+}
+
+// Accepts h:mm:ss.zzz, m:ss or plain seconds; an empty field means none.
+static bool parseCueTime(const QString &text, int *msec)
+{
+    QString t = text.trimmed();
+    *msec = 0;
+    if (t.isEmpty())
+        return true;
+    bool ok;
+    double seconds = t.toDouble(&ok);
+    if (ok && seconds >= 0) {
+        *msec = int(seconds * 1000);
+        return true;
+    }
+    for (const char *format : { "H:mm:ss.zzz", "H:mm:ss", "m:ss.zzz", "m:ss" }) {
+        QTime time = QTime::fromString(t, format);
+        if (time.isValid()) {
+            *msec = time.msecsSinceStartOfDay();
+            return true;
+        }
+    }
+    return false;
+}
+
+void MainWindow::on_cueInOut_clicked()
+{
+    int i = ui->cueList->currentRow();
+    if (i < 0 || cues[i].kind != Cue::VideoCue)
+        return;
+    Cue &cue = cues[i];
+    auto time = [](int msec) {
+        return msec ? QTime(0,0).addMSecs(msec).toString("H:mm:ss.zzz") : QString();
+    };
+    bool ok;
+    QString text = QInputDialog::getText(this, tr("Cue in and out points"),
+                                         tr("In - out (e.g. 2:13 - 3:40):"),
+                                         QLineEdit::Normal,
+                                         time(cue.msecIn) + " - " + time(cue.msecOut),
+                                         &ok);
+    if (!ok)
+        return;
+    QStringList parts = text.split('-');
+    int msecIn, msecOut;
+    if (parts.count() > 2 || !parseCueTime(parts.value(0), &msecIn)
+            || !parseCueTime(parts.value(1), &msecOut)
+            || (msecOut && msecOut <= msecIn)) {
+        QMessageBox::warning(this, tr("Cue in and out points - Presenter"),
+                             tr("Could not read the times \"%1\".").arg(text));
+        return;
+    }
+    cue.msecIn = msecIn;
+    cue.msecOut = msecOut;
+    store.putCue(cue);
+    ui->cueList->item(i)->setText(cue.toString());
+    updateCues();
+}
+
+void MainWindow::on_cueList_currentRowChanged(int row)
+{
+    if (cueList.isRunning() || row < 0)
+        return;
+    useDisplayGeometry();
+    cueList.standBy(row);
 }
 
 void MainWindow::on_monitorCombo_currentIndexChanged(int index)
@@ -395,6 +1127,262 @@ void MainWindow::on_monitorCombo_currentIndexChanged(int index)
         return;
     usedDisplayGeometry = screenAreas[index];
     displayWidget.setGeometry(usedDisplayGeometry);
+    standbyWidget.setGeometry(usedDisplayGeometry);
+    updateMirrors();
+}
+
+void MainWindow::on_actionShowOpenBundle_triggered()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Open bundle"), QString(),
+                                                tr("Show bundles (*.prb)"));
+    if (path.isEmpty())
+        return;
+    if (!bundle.open(path)) {
+        QMessageBox::warning(this, tr("Open bundle - Presenter"),
+                             tr("Could not open %1: %2").arg(path, bundle.errorString()));
+        return;
+    }
+    useDisplayGeometry();
+    QSize bundleSize = bundle.outputSize();
+    QSize outputSize = usedDisplayGeometry.size();
+    if (!bundle.matches(outputSize)) {
+        QMessageBox::warning(this, tr("Open bundle - Presenter"),
+                             tr("This bundle was exported for a %1x%2 output, but "
+                                "the output is %3x%4.  Images will be decoded "
+                                "from their original files.")
+                             .arg(bundleSize.width()).arg(bundleSize.height())
+                             .arg(outputSize.width()).arg(outputSize.height()));
+    }
+
+    slideshow.stop();
+    on_countdownClear_clicked();
+    on_imagesClear_clicked();
+    for (auto c : bundle.countdowns()) {
+        c->storeId = store.putCountdown(*c);
+        scheduleCountdown(c);
+    }
+    for (auto &item : bundle.items())
+        appendImage(item.filename, item.dwellSeconds);
+    stageImages();
+}
+
+void MainWindow::on_actionShowExportBundle_triggered()
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("Export bundle"), QString(),
+                                                tr("Show bundles (*.prb)"));
+    if (path.isEmpty())
+        return;
+    useDisplayGeometry();
+    QSize outputSize = usedDisplayGeometry.size();
+
+    QList<ShowBundle::Item> items;
+    for (int i = 0; i < ui->imagesList->count(); i++) {
+        auto item = ui->imagesList->item(i);
+        items.append({ item->text(), item->data(dwellRole).toInt(), QImage() });
+    }
+
+    QProgressDialog progress(tr("Scaling images..."), tr("Cancel"),
+                             0, items.count(), this);
+    progress.setWindowModality(Qt::WindowModal);
+    int done = 0;
+    auto prepareFrame = [&](const ShowBundle::Item &item, QImage *frame) {
+        progress.setValue(done++);
+        if (progress.wasCanceled())
+            return false;
+        if (!DisplayWidget::isMediaFile(item.filename))
+            *frame = DisplayWidget::prepareImage(mediaCache.localPath(item.filename),
+                                                 outputSize);
+        return true;
+    };
+    QString error;
+    bool written = ShowBundle::write(path, outputSize, items, countdowns,
+                                     prepareFrame, &error);
+    progress.setValue(items.count());
+    if (!written)
+        QMessageBox::warning(this, tr("Export bundle - Presenter"),
+                             tr("Could not write %1: %2").arg(path, error));
+}
+
+// The selected countdown's duration, or one asked for.
+void MainWindow::on_actionShowRenderCountdown_triggered()
+{
+    int msecDuration;
+    int i = ui->countdownList->currentRow();
+    if (i >= 0) {
+        msecDuration = countdowns[i]->duration.msecsSinceStartOfDay();
+    } else {
+        bool ok;
+        int minutes = QInputDialog::getInt(this, tr("Render countdown"),
+                                           tr("Minutes:"), 5, 1, 59, 1, &ok);
+        if (!ok)
+            return;
+        msecDuration = minutes * 60000;
+    }
+    OfflineRender::Job job;
+    job.countdownMsec = msecDuration;
+    renderOffline(job, tr("Render countdown"));
+}
+
+void MainWindow::on_actionShowRenderSlideshow_triggered()
+{
+    OfflineRender::Job job;
+    for (int i = 0; i < ui->imagesList->count(); i++) {
+        auto item = ui->imagesList->item(i);
+        if (DisplayWidget::isMediaFile(item->text()))
+            continue;
+        int dwell = item->data(dwellRole).toInt();
+        job.slides.append({ mediaCache.localPath(item->text()),
+                            (dwell > 0 ? dwell : ui->slideshowDwell->value()) * 1000 });
+    }
+    if (job.slides.isEmpty())
+        return;
+    job.crossfade = ui->slideshowCrossfade->isChecked();
+    renderOffline(job, tr("Render slideshow"));
+}
+
+void MainWindow::renderOffline(OfflineRender::Job job, const QString &title)
+{
+    if (renderThread)
+        return;
+    job.path = QFileDialog::getSaveFileName(this, title, QString(),
+        tr("Videos (*.mp4 *.mkv *.webm);;PNG sequence (*.png)"));
+    if (job.path.isEmpty())
+        return;
+    useDisplayGeometry();
+    job.size = displayWidget.outputSize();
+    job.fps = settings.value(settingRenderFps, 30).toInt();
+
+    // The export runs on its own thread so that the output carries on; the
+    // dialog only shows progress, which is queued to it, and asks the
+    // render to stop.  It is deleted after the thread has finished, so
+    // progress posted before then always finds it.
+    auto *progress = new QProgressDialog(tr("Rendering frames..."), tr("Cancel"), 0, 1, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    renderCancelled = false;
+    connect(progress, &QProgressDialog::canceled,
+            this, [this]() { renderCancelled = true; });
+    auto report = [this, progress](int done, int total) {
+        QMetaObject::invokeMethod(progress, [progress, done, total]() {
+            progress->setMaximum(total);
+            progress->setValue(done);
+        }, Qt::QueuedConnection);
+        return !renderCancelled;
+    };
+    QSharedPointer<QString> error(new QString);
+    QSharedPointer<bool> ok(new bool(false));
+    QElapsedTimer clock;
+    clock.start();
+    renderThread = QThread::create([job, report, error, ok]() {
+        *ok = OfflineRender::render(job, report, error.data());
+    });
+    renderThread->setObjectName("offline render");
+    connect(renderThread, &QThread::finished,
+            this, [this, progress, job, title, error, ok, clock]() {
+        renderThread->deleteLater();
+        renderThread = nullptr;
+        progress->deleteLater();
+        if (!*ok) {
+            QMessageBox::warning(this, title + tr(" - Presenter"),
+                                 tr("Could not render %1: %2").arg(job.path, *error));
+            return;
+        }
+        qInfo().noquote() << QString("Rendered %1 in %2 ms")
+                             .arg(job.path).arg(clock.elapsed());
+    });
+    progress->show();
+    renderThread->start();
+}
+
+// The ring is sized for the output as it is now; frames from a larger
+// output later on are counted as dropped until sharing is restarted.
+void MainWindow::on_actionShowShareFrames_toggled(bool checked)
+{
+    if (!checked) {
+        cueList.output()->setFrameExport(nullptr);
+        frameExport.close();
+        return;
+    }
+    useDisplayGeometry();
+    QString name = settings.value(settingShareFramesName,
+                                  FrameExport::defaultName()).toString();
+    int depth = settings.value(settingShareFramesDepth, 4).toInt();
+    QSize maxSize = displayWidget.outputSize() * displayWidget.devicePixelRatioF();
+    if (!frameExport.open(name, maxSize, depth)) {
+        qWarning().noquote() << QString("Frame sharing %1 unavailable: %2")
+                                .arg(name, frameExport.errorString());
+        QSignalBlocker blocker(ui->actionShowShareFrames);
+        ui->actionShowShareFrames->setChecked(false);
+        return;
+    }
+    cueList.output()->setFrameExport(&frameExport);
+}
+
+void MainWindow::on_actionShowLowerThird_triggered()
+{
+    bool ok;
+    QString text = QInputDialog::getMultiLineText(this, tr("Lower third - Presenter"),
+            tr("Name on the first line, title below; empty to hide:"),
+            displayWidget.overlayText(TextOverlay::LowerThird), &ok);
+    if (ok)
+        setOverlayText(TextOverlay::LowerThird, text.trimmed());
+}
+
+void MainWindow::on_actionShowCaption_triggered()
+{
+    bool ok;
+    QString text = QInputDialog::getText(this, tr("Caption - Presenter"),
+            tr("Caption; empty to hide:"), QLineEdit::Normal,
+            displayWidget.overlayText(TextOverlay::Caption), &ok);
+    if (ok)
+        setOverlayText(TextOverlay::Caption, text.trimmed());
+}
+
+void MainWindow::on_actionShowClock_toggled(bool checked)
+{
+    displayWidget.setClockVisible(checked);
+    standbyWidget.setClockVisible(checked);
+}
+
+void MainWindow::on_actionShowClearText_triggered()
+{
+    setOverlayText(TextOverlay::LowerThird, QString());
+    setOverlayText(TextOverlay::Caption, QString());
+    ui->actionShowClock->setChecked(false);
+}
+
+void MainWindow::on_actionShowZoneLayout_triggered()
+{
+    QString path = QFileDialog::getOpenFileName(this, tr("Zone layout"), QString(),
+                                                tr("Zone layouts (*.layout);;All files (*.*)"));
+    if (path.isEmpty())
+        return;
+    QString error;
+    if (!setZoneLayout(path, &error))
+        QMessageBox::warning(this, tr("Zone layout - Presenter"),
+                             tr("Could not use %1: %2").arg(path, error));
+}
+
+void MainWindow::on_actionShowFullScreenLayout_triggered()
+{
+    setZoneLayout(QString(), nullptr);
+}
+
+void MainWindow::on_actionDiagnosticsTrace_toggled(bool checked)
+{
+    Trace::setRecording(checked);
+}
+
+void MainWindow::on_actionDiagnosticsSaveTrace_triggered()
+{
+    QString path = QFileDialog::getSaveFileName(this, tr("Save trace"), QString(),
+                                                tr("Trace files (*.json)"));
+    if (path.isEmpty())
+        return;
+    if (!Trace::save(path))
+        QMessageBox::warning(this, tr("Save trace - Presenter"),
+                             tr("Could not write %1.").arg(path));
 }
 
 void MainWindow::on_actionHelpAboutPresenter_triggered()
@@ -17,12 +17,26 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include <atomic>
 #include <QListWidget>
 #include <QMainWindow>
 #include <QSettings>
 #include <QSystemTrayIcon>
+#include "audiostingers.h"
 #include "common.h"
+#include "controlserver.h"
+#include "cuelist.h"
 #include "displaywidget.h"
+#include "frameexport.h"
+#include "mediacache.h"
+#include "memorybudget.h"
+#include "offlinerender.h"
+#include "showbundle.h"
+#include "showstore.h"
+#include "slideshow.h"
+#include "watchdog.h"
+
+class QLabel;
 
 namespace Ui {
 class MainWindow;
@@ -31,21 +45,28 @@ class MainWindow;
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
+    friend class LatencyHarness;
 
 public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
     bool startMinimized();
     bool startVisible();
+    void runCommands(const QList<QByteArray> &commands);
 
     void restoreSettings();
     void saveSettings();
 
+signals:
+    void displayGeometryApplied();
+
 public slots:
     void populateScreens();
 
 protected:
     void closeEvent(QCloseEvent *event);
+    void showEvent(QShowEvent *event);
+    void changeEvent(QEvent *event);
     void dragMoveEvent(QDragMoveEvent *event);
     void dragEnterEvent(QDragEnterEvent *event);
     void dropEvent(QDropEvent *event);
@@ -55,12 +76,32 @@ private:
     void setupTrayIcon();
     void setupScreens();
     void useDisplayGeometry();
+    void populateMirrorMenu();
+    void updateMirrors();
 
     void appendCountdown(QSharedPointer<Countdown> c);
+    void scheduleCountdown(QSharedPointer<Countdown> c);
+    void setCountdownBackground(const QString &filename);
+    bool setZoneLayout(const QString &path, QString *error);
+    void prepareZoneStills();
+    void loadStinger(const char *setting, const QString &defaultFile, double chimeFrequency);
+    void scheduleStinger(DisplayWidget *output, const QDateTime &endTime,
+                         qint64 msecBefore, const char *setting);
     void appendImages(const QStringList &images);
+    void appendImage(const QString &filename, int dwellSeconds = 0, quint32 id = 0);
+    void appendCue(Cue cue);
+    void updateCues();
+    void saveImageOrder();
+    QStringList imageFiles() const;
+    void stageImages();
+    void renderOffline(OfflineRender::Job job, const QString &title);
     void startCountdown(int msecDuration);
     void startCountdownPartway(int msecsPosition, int msecsDuration);
     void startImage(const QString &filename);
+    void startItem(int index);
+    void stepItem(int delta);
+    void stopOutput();
+    void setOverlayText(TextOverlay::Block block, const QString &text);
 
 private slots:
     void on_countdownAdd_clicked();
@@ -77,6 +118,8 @@ private slots:
 
     void on_countdownList_itemDoubleClicked(QListWidgetItem *item);
 
+    void on_countdownBackground_clicked();
+
     void on_imagesAdd_clicked();
 
     void on_imagesRemove_clicked();
@@ -91,8 +134,58 @@ private slots:
 
     void on_imagesList_currentTextChanged(const QString &currentText);
 
+    void on_imagesStage_toggled(bool checked);
+
+    void on_imagesStageLimit_valueChanged(int value);
+
+    void on_slideshowItemDwell_clicked();
+
+    void on_slideshowStart_clicked();
+
+    void on_cueAddCountdown_clicked();
+
+    void on_cueAddFiles_clicked();
+
+    void on_cueRemove_clicked();
+
+    void on_cueClear_clicked();
+
+    void on_cueBack_clicked();
+
+    void on_cueGo_clicked();
+
+    void on_cueInOut_clicked();
+
+    void on_cueList_currentRowChanged(int row);
+
     void on_monitorCombo_currentIndexChanged(int index);
 
+    void on_actionShowOpenBundle_triggered();
+
+    void on_actionShowExportBundle_triggered();
+
+    void on_actionShowRenderCountdown_triggered();
+
+    void on_actionShowRenderSlideshow_triggered();
+
+    void on_actionShowShareFrames_toggled(bool checked);
+
+    void on_actionShowLowerThird_triggered();
+
+    void on_actionShowCaption_triggered();
+
+    void on_actionShowClock_toggled(bool checked);
+
+    void on_actionShowClearText_triggered();
+
+    void on_actionShowZoneLayout_triggered();
+
+    void on_actionShowFullScreenLayout_triggered();
+
+    void on_actionDiagnosticsTrace_toggled(bool checked);
+
+    void on_actionDiagnosticsSaveTrace_triggered();
+
     void on_actionHelpAboutPresenter_triggered();
 
     void on_actionHelpAboutQt_triggered();
@@ -105,13 +198,44 @@ private:
     Ui::MainWindow *ui;
     QSystemTrayIcon icon;
     QSettings settings;
+    ShowStore store;
+    FrameExport frameExport;
     DisplayWidget displayWidget;
-    DisplayWidget *imagesPreview;
+    DisplayWidget *imagesPreview = nullptr;
+    JobScheduler::Handle previewJob;
+    Slideshow slideshow;
+    DisplayWidget standbyWidget;
+    CueList cueList;
+    MediaCache mediaCache;
+    ShowBundle bundle;
+    ControlServer control;
+    Watchdog watchdog;
+    QLabel *lagLabel;
+    QLabel *memoryLabel;
+    QLabel *exportLabel;
+    QLabel *streamLabel;
+    AudioStingers stingers;
+    QLabel *stingerLabel;
 
     QList<QRect> screenAreas;
     QList<QSharedPointer<Countdown>> countdowns;
+    QList<Cue> cues;
 
     QRect usedDisplayGeometry;
+    QList<QRect> mirrorGeometries;
+    QList<QSharedPointer<DisplayWidget>> mirrorOutputs;
+    bool spanOutputs = false;
+    int spanBezel = 0;
+    StreamCache streamCache;
+    QString countdownBackground;
+    QString zoneLayoutPath;
+    ZoneLayout zoneLayout;
+    QSize zoneStillsSize;
+    QList<JobScheduler::Handle> zoneStillJobs;
+    MemoryBudget::Account zoneStillMemory { MemoryBudget::ZoneStills };
+    QMap<QString,QString> stingerFiles;
+    QThread *renderThread = nullptr;
+    std::atomic<bool> renderCancelled { false };
 };
 
 #endif // MAINWINDOW_H
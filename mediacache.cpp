@@ -0,0 +1,324 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <algorithm>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QStandardPaths>
+#include <QThread>
+#include "mediacache.h"
+
+constexpr qint64 chunkSize = 256*1024;
+// Bandwidth waits are sliced so that a cancel is seen promptly.
+constexpr qint64 throttleSliceMsec = 50;
+
+static const char partSuffix[] = ".part";
+static const char manifestSuffix[] = ".sha256";
+static const char chunkPrefix[] = "part ";
+
+// Cached files keep their suffix so that media type detection still works.
+static QString cacheName(const QFileInfo &source)
+{
+    QByteArray key = QCryptographicHash::hash(source.absoluteFilePath().toUtf8(),
+                                              QCryptographicHash::Sha1).toHex();
+    QString suffix = source.suffix();
+    return suffix.isEmpty() ? QString(key) : QString("%1.%2").arg(QString(key), suffix);
+}
+
+// Size and modification time identify the version of the source we copied.
+static QByteArray sourceStamp(const QFileInfo &source)
+{
+    return QString("%1 %2").arg(source.size())
+            .arg(source.lastModified().toMSecsSinceEpoch()).toUtf8();
+}
+
+static QByteArray fileHash(QFile &file)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!file.seek(0) || !hash.addData(&file))
+        return QByteArray();
+    return hash.result().toHex();
+}
+
+// A manifest holds the source stamp and then either the hash of the whole
+// copy, or while copying, one "part <hash>" line per chunk as read from the
+// source.  A resume checks the local prefix against the chunk hashes
+// instead of reading it from the source again.
+static QList<QByteArray> readManifest(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly))
+        return {};
+    return f.readAll().split('\n');
+}
+
+static bool isComplete(const QList<QByteArray> &manifest)
+{
+    return manifest.count() == 2 && !manifest[1].startsWith(chunkPrefix);
+}
+
+// Chunk hashes up to the first line torn by an interruption.
+static QList<QByteArray> chunkHashes(const QList<QByteArray> &manifest)
+{
+    QList<QByteArray> hashes;
+    for (int i = 1; i < manifest.count(); i++) {
+        const QByteArray &line = manifest[i];
+        QByteArray hash = line.mid(int(sizeof(chunkPrefix)) - 1);
+        if (!line.startsWith(chunkPrefix) || hash.size() != 64)
+            break;
+        hashes.append(hash);
+    }
+    return hashes;
+}
+
+static bool writeManifest(const QString &path, const QByteArray &stamp,
+                          const QList<QByteArray> &lines = {})
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    f.write(stamp);
+    for (const QByteArray &line : lines)
+        f.write("\n" + line);
+    return true;
+}
+
+MediaCache::MediaCache(QObject *parent) : QObject(parent)
+{
+    dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + "/media";
+}
+
+MediaCache::~MediaCache()
+{
+    cancel();
+    for (JobScheduler::Handle &run : runs)
+        run.wait();
+}
+
+void MediaCache::setDirectory(const QString &path)
+{
+    if (path == dir)
+        return;
+    cancel();
+    QMutexLocker lock(&mutex);
+    dir = path;
+    staged.clear();
+}
+
+QString MediaCache::directory() const
+{
+    return dir;
+}
+
+void MediaCache::setBandwidthLimit(qint64 bytesPerSecond)
+{
+    bandwidthLimit = std::max(bytesPerSecond, 0ll);
+}
+
+bool MediaCache::isStaging() const
+{
+    return staging.isActive();
+}
+
+QString MediaCache::localPath(const QString &filename) const
+{
+    QMutexLocker lock(&mutex);
+    return staged.value(filename, filename);
+}
+
+void MediaCache::stage(const QStringList &files)
+{
+    // Restarting is cheap: finished files are skipped and partial ones resume.
+    cancel();
+    QString directory = dir;
+    qint64 limit = bandwidthLimit;
+    int current = generation;
+    staging = JobScheduler::instance()->submit(JobScheduler::Indexing, QString(),
+            [this, current, files, directory, limit](const JobScheduler::Job &job) {
+        run(job, current, files, directory, limit);
+        return QVariant();
+    });
+    runs.append(staging);
+}
+
+// Returns at once; a copy in progress stops at its next chunk.
+void MediaCache::cancel()
+{
+    generation++;
+    staging.cancel();
+    runs.erase(std::remove_if(runs.begin(), runs.end(),
+                              [](const JobScheduler::Handle &run) {
+        return run.isFinished();
+    }), runs.end());
+}
+
+void MediaCache::run(const JobScheduler::Job &job, int runGeneration,
+                     const QStringList &files, const QString &directory,
+                     qint64 limit)
+{
+    // Two runs copying into the same part files would corrupt them.
+    QMutexLocker runLock(&runMutex);
+    if (job.isCancelled())
+        return;
+    if (!QDir().mkpath(directory)) {
+        qWarning() << "media cache: cannot create" << directory;
+        emit finished();
+        return;
+    }
+
+    QList<QPair<QString,QFileInfo>> sources;
+    qint64 total = 0;
+    qint64 done = 0;
+    for (const QString &filename : files) {
+        QFileInfo source(filename);
+        if (source.isFile())
+            total += source.size();
+        sources.append({filename, source});
+    }
+    emit progress(done, total);
+
+    for (const auto &s : sources) {
+        if (job.isCancelled())
+            break;
+        QString local = stageFile(job, s.second, directory, limit, done, total);
+        if (local.isEmpty())
+            continue;
+        mutex.lock();
+        bool current = runGeneration == generation;
+        if (current)
+            staged.insert(s.first, local);
+        mutex.unlock();
+        if (current)
+            emit fileStaged(s.first);
+    }
+    if (runGeneration == generation)
+        emit finished();
+}
+
+QString MediaCache::stageFile(const JobScheduler::Job &job, const QFileInfo &source,
+                              const QString &directory, qint64 limit, qint64 &done,
+                              qint64 total)
+{
+    QString target = QDir(directory).filePath(cacheName(source));
+    QString partName = target + partSuffix;
+    QString manifestName = target + manifestSuffix;
+    QList<QByteArray> manifest = readManifest(manifestName);
+    bool complete = isComplete(manifest) && QFileInfo::exists(target);
+
+    // The share may have gone away; a verified copy is still good to play.
+    if (!source.isFile())
+        return complete ? target : QString();
+
+    QByteArray stamp = sourceStamp(source);
+    bool sameSource = !manifest.isEmpty() && manifest[0] == stamp;
+    if (complete && sameSource) {
+        done += source.size();
+        emit progress(done, total);
+        return target;
+    }
+
+    QFile in(source.absoluteFilePath());
+    QFile out(partName);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::ReadWrite)) {
+        qWarning() << "media cache: cannot copy" << source.filePath();
+        return QString();
+    }
+    QList<QByteArray> hashes;
+    if (sameSource && out.size() <= source.size() && !isComplete(manifest))
+        hashes = chunkHashes(manifest);
+
+    // Resume after the longest local prefix whose chunks match the hashes
+    // taken from the source, so that a prefix damaged before the
+    // interruption is copied again rather than vouching for itself.  The
+    // prefix is only read locally; the source is read from the offset on.
+    QCryptographicHash streamHash(QCryptographicHash::Sha256);
+    qint64 offset = 0;
+    int verified = 0;
+    if (!out.seek(0))
+        return QString();
+    while (verified < hashes.count() && offset < out.size()) {
+        if (job.isCancelled())
+            return QString();
+        QByteArray chunk = out.read(std::min(chunkSize, out.size() - offset));
+        if (chunk.isEmpty() || QCryptographicHash::hash(chunk, QCryptographicHash::Sha256)
+                .toHex() != hashes[verified])
+            break;
+        streamHash.addData(chunk);
+        offset += chunk.size();
+        verified++;
+    }
+    hashes = hashes.mid(0, verified);
+    QList<QByteArray> lines;
+    for (const QByteArray &hash : hashes)
+        lines.append(chunkPrefix + hash);
+    if (!out.resize(offset) || !out.seek(offset) || !in.seek(offset)
+            || !writeManifest(manifestName, stamp, lines))
+        return QString();
+    done += offset;
+    emit progress(done, total);
+
+    QFile chunkLog(manifestName);
+    if (!chunkLog.open(QIODevice::WriteOnly | QIODevice::Append))
+        return QString();
+    QElapsedTimer clock;
+    clock.start();
+    qint64 read = offset;
+    while (read < source.size()) {
+        if (job.isCancelled())
+            return QString();
+        QByteArray chunk = in.read(chunkSize);
+        if (chunk.isEmpty() || out.write(chunk) != chunk.size() || !out.flush()) {
+            qWarning() << "media cache: read failed for" << source.filePath();
+            return QString();
+        }
+        streamHash.addData(chunk);
+        chunkLog.write("\n" + QByteArray(chunkPrefix)
+                       + QCryptographicHash::hash(chunk, QCryptographicHash::Sha256).toHex());
+        chunkLog.flush();
+        read += chunk.size();
+        done += chunk.size();
+        emit progress(done, total);
+
+        if (limit > 0) {
+            qint64 due = (read - offset) * 1000 / limit;
+            for (qint64 wait = due - clock.elapsed(); wait > 0;
+                 wait = due - clock.elapsed()) {
+                if (job.isCancelled())
+                    return QString();
+                QThread::msleep(std::min(wait, throttleSliceMsec));
+            }
+        }
+    }
+    chunkLog.close();
+
+    // Verify what landed on disk against what was read from the source.
+    QByteArray localHash = fileHash(out);
+    out.close();
+    if (localHash.isEmpty() || localHash != streamHash.result().toHex()) {
+        qWarning() << "media cache: checksum mismatch for" << source.filePath();
+        QFile::remove(partName);
+        return QString();
+    }
+    QFile::remove(target);
+    if (!QFile::rename(partName, target)
+            || !writeManifest(manifestName, stamp, { localHash }))
+        return QString();
+    return target;
+}
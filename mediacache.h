@@ -0,0 +1,74 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef MEDIACACHE_H
+#define MEDIACACHE_H
+
+#include <atomic>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QStringList>
+#include "jobscheduler.h"
+
+// Copies playlist media from slow or removable storage into a local
+// directory so that playback never reads from the original location.
+// Copies are resumable across runs and verified with SHA-256.
+class MediaCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MediaCache(QObject *parent = nullptr);
+    ~MediaCache();
+
+    void setDirectory(const QString &path);
+    QString directory() const;
+    void setBandwidthLimit(qint64 bytesPerSecond);
+    bool isStaging() const;
+
+    QString localPath(const QString &filename) const;
+
+signals:
+    void progress(qint64 bytesDone, qint64 bytesTotal);
+    void fileStaged(const QString &filename);
+    void finished();
+
+public slots:
+    void stage(const QStringList &files);
+    void cancel();
+
+private:
+    void run(const JobScheduler::Job &job, int runGeneration, const QStringList &files,
+             const QString &directory, qint64 limit);
+    QString stageFile(const JobScheduler::Job &job, const QFileInfo &source,
+                      const QString &directory, qint64 limit, qint64 &done,
+                      qint64 total);
+
+    mutable QMutex mutex;
+    QHash<QString,QString> staged;
+    QString dir;
+    qint64 bandwidthLimit = 0;
+    JobScheduler::Handle staging;
+    // Cancelled runs may still be finishing a read; they are ignored by
+    // generation, and one run at a time holds runMutex.
+    QList<JobScheduler::Handle> runs;
+    std::atomic<int> generation { 0 };
+    QMutex runMutex;
+};
+
+#endif // MEDIACACHE_H
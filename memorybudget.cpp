@@ -0,0 +1,169 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QPixmapCache>
+#include "memorybudget.h"
+#include "trace.h"
+
+#ifdef Q_OS_LINUX
+#include <malloc.h>
+#include <unistd.h>
+#endif
+
+std::atomic<qint64> MemoryBudget::counters[SubsystemCount] {};
+
+static QString megabytes(qint64 bytes)
+{
+    return QString::number(bytes / (1024.0 * 1024.0), 'f', 1);
+}
+
+void MemoryBudget::Account::set(qint64 bytes)
+{
+    counters[subsystem].fetch_add(bytes - held, std::memory_order_relaxed);
+    held = bytes;
+}
+
+MemoryBudget *MemoryBudget::instance()
+{
+    static MemoryBudget *budget = new MemoryBudget(qApp);
+    return budget;
+}
+
+MemoryBudget::MemoryBudget(QObject *parent) : QObject(parent)
+{
+    connect(&sampler, &QTimer::timeout, this, &MemoryBudget::sample);
+    sampler.start(sampleMsec);
+}
+
+qint64 MemoryBudget::bytes(Subsystem subsystem)
+{
+    return counters[subsystem].load(std::memory_order_relaxed);
+}
+
+QString MemoryBudget::subsystemName(Subsystem subsystem)
+{
+    switch (subsystem) {
+    case DisplayImages:
+        return tr("display images");
+    case SlideshowImages:
+        return tr("slideshow");
+    case MpvDemuxer:
+        return tr("mpv demuxer cache");
+    case BundleMapping:
+        return tr("show bundle (mapped)");
+    case OverlayPixmaps:
+        return tr("text overlays");
+    case ZoneStills:
+        return tr("zone stills");
+    case StingerAudio:
+        return tr("stingers");
+    case GlBuffers:
+        return tr("GL buffers");
+    case FrameSharing:
+        return tr("frame sharing");
+    default:
+        return QString();
+    }
+}
+
+// Zero where the platform offers no cheap way to read it.
+qint64 MemoryBudget::residentBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.count() < 2)
+        return 0;
+    return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+void MemoryBudget::setBudget(qint64 bytes)
+{
+    budgetBytes = bytes;
+    sample();
+}
+
+qint64 MemoryBudget::budget() const
+{
+    return budgetBytes;
+}
+
+bool MemoryBudget::underPressure() const
+{
+    return pressured;
+}
+
+qint64 MemoryBudget::lastResident() const
+{
+    return resident;
+}
+
+QString MemoryBudget::statsText() const
+{
+    QString text = tr("Memory: %1 MB").arg(megabytes(resident));
+    if (budgetBytes > 0)
+        text += tr(" of %1 MB").arg(megabytes(budgetBytes));
+    if (pressured)
+        text += tr(", shedding");
+    return text;
+}
+
+QString MemoryBudget::detailText() const
+{
+    QStringList lines;
+    for (int i = 0; i < SubsystemCount; i++)
+        lines.append(tr("%1: %2 MB").arg(subsystemName(Subsystem(i)),
+                                          megabytes(bytes(Subsystem(i)))));
+    return lines.join('\n');
+}
+
+void MemoryBudget::sample()
+{
+    TRACE_SPAN("memory.sample");
+    resident = residentBytes();
+    if (budgetBytes > 0 && resident > budgetBytes) {
+        if (!pressured)
+            qWarning().noquote() << QString("Memory over budget: %1 MB of %2 MB; %3")
+                                    .arg(megabytes(resident), megabytes(budgetBytes),
+                                         detailText().replace('\n', ", "));
+        pressured = true;
+        emit pressure();
+        QPixmapCache::clear();
+        releaseHeap();
+    } else if (pressured && (budgetBytes <= 0 || resident < budgetBytes * 4 / 5)) {
+        pressured = false;
+        qInfo().noquote() << QString("Memory back under budget: %1 MB")
+                             .arg(megabytes(resident));
+        emit relieved();
+    }
+    emit statsChanged();
+}
+
+// Freed buffers otherwise stay in the allocator and keep counting as RSS.
+void MemoryBudget::releaseHeap()
+{
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+    malloc_trim(0);
+#endif
+}
@@ -0,0 +1,85 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <atomic>
+#include <QObject>
+#include <QTimer>
+
+// Byte counters for the large buffers each subsystem holds, sampled along
+// with the resident set size of the process.  With a budget set, every
+// sample taken over budget emits pressure() so that owners can drop or
+// shrink what they are able to rebuild; relieved() follows once usage has
+// fallen back well below the budget.
+class MemoryBudget : public QObject
+{
+    Q_OBJECT
+public:
+    enum Subsystem { DisplayImages, SlideshowImages, MpvDemuxer, BundleMapping,
+                     OverlayPixmaps, ZoneStills, StingerAudio, GlBuffers,
+                     FrameSharing, SubsystemCount };
+
+    // Tracks the bytes one owner holds in a subsystem; the counter is
+    // adjusted by the difference on every set() and on destruction.
+    class Account
+    {
+    public:
+        explicit Account(Subsystem subsystem) : subsystem(subsystem) { }
+        ~Account() { set(0); }
+        void set(qint64 bytes);
+        Account(const Account &) = delete;
+        Account &operator=(const Account &) = delete;
+
+    private:
+        Subsystem subsystem;
+        qint64 held = 0;
+    };
+
+    static MemoryBudget *instance();
+
+    static qint64 bytes(Subsystem subsystem);
+    static QString subsystemName(Subsystem subsystem);
+    static qint64 residentBytes();
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const;
+    bool underPressure() const;
+    qint64 lastResident() const;
+    QString statsText() const;
+    QString detailText() const;
+
+signals:
+    void pressure();
+    void relieved();
+    void statsChanged();
+
+private:
+    explicit MemoryBudget(QObject *parent = nullptr);
+    void sample();
+    void releaseHeap();
+
+    static constexpr int sampleMsec = 2000;
+    static std::atomic<qint64> counters[SubsystemCount];
+
+    QTimer sampler;
+    qint64 budgetBytes = 0;
+    qint64 resident = 0;
+    bool pressured = false;
+};
+
+#endif // MEMORYBUDGET_H
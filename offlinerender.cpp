@@ -0,0 +1,284 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <algorithm>
+#include <atomic>
+#include <QFileInfo>
+#include <QPainter>
+#include <QThread>
+#include <QVector>
+#include "displaywidget.h"
+#include "jobscheduler.h"
+#include "offlinerender.h"
+#include "trace.h"
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <mpv/client.h>
+#endif
+
+// Raw frames are handed to the encoder in the painter's native format,
+// which is B, G, R, X in memory on little-endian hosts.
+constexpr QImage::Format renderFormat = QImage::Format_RGB32;
+static const char renderMpvFormat[] = "bgr0";
+
+// Exports are started by the operator, but must not hold up the output.
+constexpr JobScheduler::Priority renderPriority = JobScheduler::Preview;
+
+// Everything a frame depends on, so that any frame can be painted on its
+// own and in any order.
+struct OfflineRender::Timeline {
+    QSize size;
+    double msecPerFrame;
+    int frames;
+    int countdownMsec;
+    bool crossfade;
+    QList<QImage> slides;
+    QList<qint64> slideStarts;
+    qint64 loopMsec = 0;
+
+    QImage paint(int index) const
+    {
+        TRACE_SPAN("render.frame");
+        QImage frame(size, renderFormat);
+        QPainter p(&frame);
+        QRect area(QPoint(), size);
+        DisplayWidget::paintNothing(p, area);
+        qint64 t = qint64(index * msecPerFrame);
+        if (countdownMsec > 0) {
+            double fadeIn = t / double(DisplayWidget::fadeTimeMsec);
+            double fadeOut = (countdownMsec + DisplayWidget::fadeTimeMsec - t)
+                    / double(DisplayWidget::fadeTimeMsec);
+            p.setOpacity(std::min(std::min(fadeIn, fadeOut), 1.0));
+            DisplayWidget::paintCountdown(p, area, countdownMsec - t, countdownMsec);
+        } else {
+            int k = int(std::upper_bound(slideStarts.begin(), slideStarts.end(), t)
+                        - slideStarts.begin()) - 1;
+            qint64 into = t - slideStarts[k];
+            if (crossfade && slides.count() > 1
+                    && into < DisplayWidget::transitionTimeMsec) {
+                const QImage &previous = slides[(k + slides.count() - 1) % slides.count()];
+                DisplayWidget::paintImage(p, area, slides[k], previous,
+                                          into / double(DisplayWidget::transitionTimeMsec));
+            } else {
+                DisplayWidget::paintImage(p, area, slides[k]);
+            }
+        }
+        p.end();
+        return frame;
+    }
+};
+
+bool OfflineRender::render(const Job &job, const ProgressFunction &progress,
+                           QString *error)
+{
+    auto fail = [error](const QString &reason) {
+        if (error)
+            *error = reason;
+        return false;
+    };
+    if (job.size.isEmpty() || job.fps <= 0)
+        return fail(QObject::tr("invalid frame size or rate"));
+
+    Timeline timeline;
+    timeline.size = job.size;
+    timeline.msecPerFrame = 1000.0 / job.fps;
+    timeline.countdownMsec = job.countdownMsec;
+    timeline.crossfade = job.crossfade;
+    qint64 length;
+    if (job.countdownMsec > 0) {
+        length = job.countdownMsec + DisplayWidget::fadeTimeMsec;
+    } else {
+        // Slides are few enough to decode up front, in parallel.
+        TRACE_SPAN("render.decode");
+        QVector<QImage> decoded(job.slides.count());
+        JobScheduler::instance()->map(renderPriority, job.slides.count(), [&](int i) {
+            decoded[i] = DisplayWidget::prepareImage(job.slides[i].filename, job.size);
+        });
+        for (int i = 0; i < decoded.count(); i++) {
+            if (decoded[i].isNull())
+                continue;
+            timeline.slides.append(decoded[i]);
+            timeline.slideStarts.append(timeline.loopMsec);
+            timeline.loopMsec += std::max(job.slides[i].dwellMsec, 1);
+        }
+        if (timeline.slides.isEmpty())
+            return fail(QObject::tr("no slides could be decoded"));
+        length = timeline.loopMsec;
+    }
+    timeline.frames = std::max(int(length / timeline.msecPerFrame), 1);
+
+    if (job.path.endsWith(".png", Qt::CaseInsensitive))
+        return writeSequence(job, timeline, progress, error);
+    return encode(job, timeline, progress, error);
+}
+
+// Frames are painted and compressed entirely on the worker threads.
+bool OfflineRender::writeSequence(const Job &job, const Timeline &timeline,
+                                  const ProgressFunction &progress, QString *error)
+{
+    QFileInfo info(job.path);
+    QString pattern = info.path() + "/" + info.completeBaseName() + "-%1.png";
+    int batch = QThread::idealThreadCount() * 4;
+    std::atomic<bool> failed { false };
+    for (int first = 0; first < timeline.frames; first += batch) {
+        if (!progress(first, timeline.frames)) {
+            if (error)
+                *error = QObject::tr("render cancelled");
+            return false;
+        }
+        int count = std::min(batch, timeline.frames - first);
+        JobScheduler::instance()->map(renderPriority, count, [&](int i) {
+            QString name = pattern.arg(first + i + 1, 6, 10, QChar('0'));
+            if (!timeline.paint(first + i).save(name))
+                failed = true;
+        });
+        if (failed) {
+            if (error)
+                *error = QObject::tr("could not write frames to %1").arg(info.path());
+            return false;
+        }
+    }
+    progress(timeline.frames, timeline.frames);
+    return true;
+}
+
+#ifdef Q_OS_UNIX
+// Waits for room in the pipe while watching for the encoder giving up.
+static bool writeFrame(int fd, const QImage &frame, mpv_handle *mpv, QString *error)
+{
+    const uchar *data = frame.constBits();
+    qint64 left = frame.sizeInBytes();
+    while (left > 0) {
+        pollfd pfd { fd, POLLOUT, 0 };
+        if (poll(&pfd, 1, 100) == 0) {
+            while (mpv_event *event = mpv_wait_event(mpv, 0)) {
+                if (event->event_id == MPV_EVENT_NONE)
+                    break;
+                if (event->event_id == MPV_EVENT_END_FILE) {
+                    auto *end = static_cast<mpv_event_end_file*>(event->data);
+                    *error = QString::fromUtf8(mpv_error_string(end->error));
+                    return false;
+                }
+            }
+            continue;
+        }
+        ssize_t n = write(fd, data, size_t(left));
+        if (n < 0 && errno != EINTR && errno != EAGAIN) {
+            *error = QString::fromLocal8Bit(strerror(errno));
+            return false;
+        }
+        if (n > 0) {
+            data += n;
+            left -= n;
+        }
+    }
+    return true;
+}
+#endif
+
+// Batches are painted in parallel and then written in order, while mpv
+// encodes the previous ones on its own threads.
+bool OfflineRender::encode(const Job &job, const Timeline &timeline,
+                           const ProgressFunction &progress, QString *error)
+{
+#ifdef Q_OS_UNIX
+    QString reason;
+    mpv_handle *mpv = mpv_create();
+    if (!mpv) {
+        if (error)
+            *error = QObject::tr("could not create mpv context");
+        return false;
+    }
+    QByteArray path = job.path.toUtf8();
+    QByteArray width = QByteArray::number(job.size.width());
+    QByteArray height = QByteArray::number(job.size.height());
+    QByteArray fps = QByteArray::number(job.fps);
+    mpv_set_option_string(mpv, "o", path.constData());
+    mpv_set_option_string(mpv, "audio", "no");
+    mpv_set_option_string(mpv, "demuxer", "rawvideo");
+    mpv_set_option_string(mpv, "demuxer-rawvideo-w", width.constData());
+    mpv_set_option_string(mpv, "demuxer-rawvideo-h", height.constData());
+    mpv_set_option_string(mpv, "demuxer-rawvideo-mp-format", renderMpvFormat);
+    mpv_set_option_string(mpv, "demuxer-rawvideo-fps", fps.constData());
+    int fds[2] = { -1, -1 };
+    if (mpv_initialize(mpv) < 0) {
+        reason = QObject::tr("could not initialize mpv context");
+    } else if (pipe(fds) < 0) {
+        reason = QString::fromLocal8Bit(strerror(errno));
+    } else {
+        fcntl(fds[1], F_SETFL, O_NONBLOCK);
+        QByteArray url = "fd://" + QByteArray::number(fds[0]);
+        const char *cmd[] = { "loadfile", url.constData(), nullptr };
+        mpv_command(mpv, cmd);
+    }
+
+    int batch = QThread::idealThreadCount() * 2;
+    QVector<QImage> frames;
+    for (int first = 0; reason.isEmpty() && first < timeline.frames; first += batch) {
+        if (!progress(first, timeline.frames)) {
+            reason = QObject::tr("render cancelled");
+            break;
+        }
+        int count = std::min(batch, timeline.frames - first);
+        frames.fill(QImage(), count);
+        JobScheduler::instance()->map(renderPriority, count, [&](int i) {
+            frames[i] = timeline.paint(first + i);
+        });
+        TRACE_SPAN("render.write");
+        for (const QImage &frame : frames)
+            if (!writeFrame(fds[1], frame, mpv, &reason))
+                break;
+    }
+
+    // Closing the pipe is the end of the stream; wait for the file to be
+    // finished.
+    if (fds[1] >= 0)
+        close(fds[1]);
+    while (reason.isEmpty() && fds[0] >= 0) {
+        mpv_event *event = mpv_wait_event(mpv, -1);
+        if (event->event_id == MPV_EVENT_SHUTDOWN)
+            break;
+        if (event->event_id == MPV_EVENT_END_FILE) {
+            auto *end = static_cast<mpv_event_end_file*>(event->data);
+            if (end->reason == MPV_END_FILE_REASON_ERROR)
+                reason = QString::fromUtf8(mpv_error_string(end->error));
+            break;
+        }
+    }
+    mpv_terminate_destroy(mpv);
+    if (fds[0] >= 0)
+        close(fds[0]);
+    progress(timeline.frames, timeline.frames);
+    if (!reason.isEmpty()) {
+        if (error)
+            *error = reason;
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(job);
+    Q_UNUSED(timeline);
+    Q_UNUSED(progress);
+    if (error)
+        *error = QObject::tr("video export needs a Unix system; export a PNG sequence");
+    return false;
+#endif
+}
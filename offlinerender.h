@@ -0,0 +1,68 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef OFFLINERENDER_H
+#define OFFLINERENDER_H
+
+#include <functional>
+#include <QImage>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+// Renders a countdown or a slideshow loop to a video file, or to a numbered
+// PNG sequence, on a virtual clock.  Frames are drawn with DisplayWidget's
+// painters, in batches spread over all cores, and videos are encoded by
+// libmpv reading raw frames from a pipe, so an export runs as fast as the
+// machine allows instead of in real time.
+//
+// A countdown fades in as it starts and fades out after reaching zero, as
+// on screen.  A slideshow runs once through and, with crossfades, opens on
+// the crossfade from its last slide, so that the file loops seamlessly.
+class OfflineRender
+{
+public:
+    struct Slide {
+        QString filename;
+        int dwellMsec;
+    };
+
+    struct Job {
+        QString path;           // *.png writes a sequence next to it
+        QSize size;
+        int fps = 30;
+        int countdownMsec = 0;  // a countdown, or else the slides
+        QList<Slide> slides;
+        bool crossfade = true;
+    };
+
+    // Called on the calling thread between batches; returning false
+    // abandons the render.  render() returns only when the file is done,
+    // so the GUI calls it from a thread of its own.
+    typedef std::function<bool(int done, int total)> ProgressFunction;
+    static bool render(const Job &job, const ProgressFunction &progress,
+                       QString *error);
+
+private:
+    struct Timeline;
+
+    static bool writeSequence(const Job &job, const Timeline &timeline,
+                              const ProgressFunction &progress, QString *error);
+    static bool encode(const Job &job, const Timeline &timeline,
+                       const ProgressFunction &progress, QString *error);
+};
+
+#endif // OFFLINERENDER_H
@@ -0,0 +1,167 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QRegularExpression>
+#include <QTextStream>
+#include "displaywidget.h"
+#include "outputzone.h"
+#include "trace.h"
+
+bool ZoneLayout::load(const QString &path, QString *error)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        *error = f.errorString();
+        return false;
+    }
+    QDir dir = QFileInfo(path).dir();
+    QRegularExpression space("\\s+");
+    main = QRectF(0, 0, 1, 1);
+    zones.clear();
+
+    QTextStream in(&f);
+    for (int lineNumber = 1; !in.atEnd(); lineNumber++) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        QStringList fields = line.split(space);
+        QString kind = fields.value(0);
+        bool ok = fields.count() >= 5;
+        qreal v[4];
+        for (int i = 0; ok && i < 4; i++)
+            v[i] = fields[i + 1].toDouble(&ok);
+        QRectF area = ok ? QRectF(v[0], v[1], v[2], v[3]) : QRectF();
+        ok = ok && area.width() > 0 && area.height() > 0
+                && QRectF(0, 0, 1, 1).contains(area);
+        if (ok && kind == "main" && fields.count() == 5) {
+            main = area;
+        } else if (ok && kind == "countdown" && fields.count() == 5) {
+            zones.append({ Countdown, area, QString(), QImage() });
+        } else if (ok && kind == "still" && fields.count() > 5) {
+            QString filename = line.section(space, 5);
+            zones.append({ Still, area, dir.absoluteFilePath(filename), QImage() });
+        } else {
+            *error = QString("line %1: %2").arg(lineNumber).arg(line);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ZoneLayout::hasCountdown() const
+{
+    for (const Zone &z : zones)
+        if (z.kind == Countdown)
+            return true;
+    return false;
+}
+
+QRect ZoneLayout::map(const QRectF &fraction, const QRect &area)
+{
+    return QRectF(area.x() + fraction.x() * area.width(),
+                  area.y() + fraction.y() * area.height(),
+                  fraction.width() * area.width(),
+                  fraction.height() * area.height()).toAlignedRect() & area;
+}
+
+OutputZone::OutputZone(const ZoneLayout::Zone &zone, QWidget *parent)
+    : QWidget(parent), zone(zone)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    tickTimer.setSingleShot(true);
+    connect(&tickTimer, &QTimer::timeout,
+            this, &OutputZone::tickTimer_timeout);
+}
+
+void OutputZone::place(const QRect &outputArea)
+{
+    setGeometry(ZoneLayout::map(zone.area, outputArea));
+}
+
+bool OutputZone::isCountdown() const
+{
+    return zone.kind == ZoneLayout::Countdown;
+}
+
+void OutputZone::setImage(const QImage &image)
+{
+    zone.image = image;
+    update();
+}
+
+// A zero duration clears the zone.
+void OutputZone::setCountdown(const QDateTime &endTime, qint64 msecDuration)
+{
+    this->endTime = endTime;
+    this->msecDuration = msecDuration;
+    tickTimer.stop();
+    framePending = msecDuration > 0;
+    if (framePending)
+        tickTimer_timeout();
+    else
+        update();
+}
+
+void OutputZone::paintZone(QPainter &p, const QRect &outputArea) const
+{
+    paintArea(p, ZoneLayout::map(zone.area, outputArea));
+}
+
+void OutputZone::paintEvent(QPaintEvent *e)
+{
+    Q_UNUSED(e);
+    TRACE_SPAN("paint.zone");
+    QPainter p(this);
+    paintArea(p, rect());
+    emit repainted();
+    if (framePending) {
+        framePending = false;
+        emit framePainted();
+    }
+}
+
+// Wakes up when the shown second changes, as rounded by paintCountdown.
+void OutputZone::tickTimer_timeout()
+{
+    update();
+    if (msecDuration <= 0)
+        return;
+    qint64 msecLeft = QDateTime::currentDateTime().msecsTo(endTime);
+    if (msecLeft <= 0) {
+        emit countdownFinished();
+        return;
+    }
+    qint64 rounded = msecLeft + DisplayWidget::updateMsec / 2;
+    tickTimer.start(rounded % 1000 + 1);
+}
+
+void OutputZone::paintArea(QPainter &p, const QRect &area) const
+{
+    if (zone.kind == ZoneLayout::Countdown && msecDuration > 0) {
+        qint64 msecLeft = QDateTime::currentDateTime().msecsTo(endTime);
+        DisplayWidget::paintCountdown(p, area, msecLeft, msecDuration);
+        return;
+    }
+    DisplayWidget::paintNothing(p, area);
+    if (zone.kind == ZoneLayout::Still && !zone.image.isNull())
+        DisplayWidget::paintImage(p, area, zone.image);
+}
@@ -0,0 +1,91 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef OUTPUTZONE_H
+#define OUTPUTZONE_H
+
+#include <QDateTime>
+#include <QImage>
+#include <QList>
+#include <QRectF>
+#include <QTimer>
+#include <QWidget>
+
+// Splits an output into a main zone, which shows what DisplayWidget would
+// show full screen, and further zones with stills or the running
+// countdown.  Layouts are text files with one zone per line, positions
+// and sizes as fractions of the output:
+//     main x y w h
+//     still x y w h <file>
+//     countdown x y w h
+// Relative still filenames are looked up next to the layout file.
+struct ZoneLayout {
+    enum Kind { Still, Countdown };
+    struct Zone {
+        Kind kind;
+        QRectF area;
+        QString filename;
+        QImage image;
+    };
+
+    QRectF main { 0, 0, 1, 1 };
+    QList<Zone> zones;
+
+    bool load(const QString &path, QString *error);
+    bool hasCountdown() const;
+
+    static QRect map(const QRectF &fraction, const QRect &area);
+};
+
+// One zone other than the main one.  A still is painted once and then only
+// when exposed; a countdown repaints once a second, when its digits change.
+// Either way only the zone's own rectangle is repainted.
+class OutputZone : public QWidget
+{
+    Q_OBJECT
+public:
+    OutputZone(const ZoneLayout::Zone &zone, QWidget *parent);
+
+    void place(const QRect &outputArea);
+    bool isCountdown() const;
+    void setImage(const QImage &image);
+    void setCountdown(const QDateTime &endTime, qint64 msecDuration);
+    void paintZone(QPainter &p, const QRect &outputArea) const;
+
+signals:
+    void framePainted();
+    // Every repaint, which being opaque never reaches the output's own
+    // paintEvent(), e.g. for frame sharing.
+    void repainted();
+    void countdownFinished();
+
+protected:
+    void paintEvent(QPaintEvent *e) Q_DECL_OVERRIDE;
+
+private slots:
+    void tickTimer_timeout();
+
+private:
+    void paintArea(QPainter &p, const QRect &area) const;
+
+    ZoneLayout::Zone zone;
+    QDateTime endTime;
+    qint64 msecDuration = 0;
+    QTimer tickTimer;
+    bool framePending = false;
+};
+
+#endif // OUTPUTZONE_H
@@ -6,7 +6,7 @@
 
 QT       += core gui
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets network multimedia
 CONFIG += c++17
 TARGET = presenter
 TEMPLATE = app
@@ -25,6 +25,8 @@ DEFINES += QT_DEPRECATED_WARNINGS
 QT_CONFIG -= no-pkg-config
 CONFIG += link_pkgconfig debug
 PKGCONFIG += mpv
+# shm_open is in librt before glibc 2.34.
+linux: LIBS += -lrt
 
 SOURCES += \
         main.cpp \
@@ -32,19 +34,71 @@ SOURCES += \
     timedialog.cpp \
     displaywidget.cpp \
     common.cpp \
-    videowidget.cpp
+    videowidget.cpp \
+    slideshow.cpp \
+    mediacache.cpp \
+    showbundle.cpp \
+    showstore.cpp \
+    trace.cpp \
+    watchdog.cpp \
+    memorybudget.cpp \
+    kiosk.cpp \
+    controlserver.cpp \
+    cuelist.cpp \
+    countdownoverlay.cpp \
+    videomirror.cpp \
+    frameexport.cpp \
+    offlinerender.cpp \
+    textoverlay.cpp \
+    outputzone.cpp \
+    audiostingers.cpp \
+    jobscheduler.cpp
 
 HEADERS += \
         mainwindow.h \
     timedialog.h \
     common.h \
     displaywidget.h \
-    videowidget.h
+    videowidget.h \
+    slideshow.h \
+    mediacache.h \
+    showbundle.h \
+    showstore.h \
+    trace.h \
+    watchdog.h \
+    memorybudget.h \
+    kiosk.h \
+    controlserver.h \
+    cuelist.h \
+    countdownoverlay.h \
+    videomirror.h \
+    frameexport.h \
+    offlinerender.h \
+    textoverlay.h \
+    outputzone.h \
+    audiostingers.h \
+    jobscheduler.h
 
 FORMS += \
         mainwindow.ui \
     timedialog.ui
 
+# Headless paint benchmark: qmake CONFIG+=benchmark builds presenter-bench,
+# which runs the DisplayWidget painters on the offscreen platform.
+benchmark {
+    TARGET = presenter-bench
+    SOURCES -= main.cpp
+    SOURCES += displaybench.cpp
+}
+
+# Trigger-to-first-frame harness: qmake CONFIG+=latency builds
+# presenter-latency, which drives MainWindow on the offscreen platform.
+latency {
+    TARGET = presenter-latency
+    SOURCES -= main.cpp
+    SOURCES += latencyharness.cpp
+}
+
 RESOURCES += \
     resources.qrc
 
@@ -0,0 +1,232 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <climits>
+#include <QDataStream>
+#include "showbundle.h"
+
+constexpr quint32 bundleMagic = 0x50524231;     // "PRB1"
+constexpr quint32 bundleVersion = 1;
+constexpr quint64 pageSize = 4096;
+constexpr QImage::Format frameFormat = QImage::Format_ARGB32_Premultiplied;
+constexpr QDataStream::Version streamVersion = QDataStream::Qt_5_6;
+
+static quint64 pageAlign(quint64 pos)
+{
+    return (pos + pageSize - 1) & ~(pageSize - 1);
+}
+
+// Frames keep the mapping alive for as long as any QImage refers to them.
+static void releaseMapping(void *info)
+{
+    delete static_cast<QSharedPointer<QFile>*>(info);
+}
+
+ShowBundle::ShowBundle()
+{
+
+}
+
+bool ShowBundle::write(const QString &path, const QSize &outputSize,
+                       const QList<Item> &items,
+                       const QList<QSharedPointer<Countdown>> &countdowns,
+                       const FrameFunction &prepareFrame,
+                       QString *error)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error)
+            *error = f.errorString();
+        return false;
+    }
+
+    QList<quint64> offsets;
+    QList<QSize> sizes;
+    QList<int> strides;
+    quint64 pos = pageSize;
+    for (const Item &item : items) {
+        QImage frame = item.frame;
+        if (!prepareFrame(item, &frame)) {
+            if (error)
+                *error = QObject::tr("export cancelled");
+            f.remove();
+            return false;
+        }
+        frame = frame.convertToFormat(frameFormat);
+        if (frame.isNull()) {
+            offsets.append(0);
+            sizes.append(QSize(0, 0));
+            strides.append(0);
+            continue;
+        }
+        pos = pageAlign(pos);
+        f.seek(pos);
+        f.write(reinterpret_cast<const char*>(frame.constBits()),
+                frame.sizeInBytes());
+        offsets.append(pos);
+        sizes.append(frame.size());
+        strides.append(frame.bytesPerLine());
+        pos += frame.sizeInBytes();
+    }
+
+    quint64 metadataOffset = pos;
+    f.seek(metadataOffset);
+    QDataStream out(&f);
+    out.setVersion(streamVersion);
+    out << quint32(items.count());
+    for (int i = 0; i < items.count(); i++) {
+        out << items[i].filename << qint32(items[i].dwellSeconds)
+            << offsets[i] << quint32(sizes[i].width())
+            << quint32(sizes[i].height()) << quint32(strides[i]);
+    }
+    out << quint32(countdowns.count());
+    for (auto &c : countdowns)
+        c->writeStream(out);
+    quint64 metadataSize = f.pos() - metadataOffset;
+
+    f.seek(0);
+    out << bundleMagic << bundleVersion
+        << quint32(outputSize.width()) << quint32(outputSize.height())
+        << metadataOffset << metadataSize;
+
+    if (out.status() != QDataStream::Ok || f.error() != QFileDevice::NoError) {
+        if (error)
+            *error = f.errorString();
+        f.remove();
+        return false;
+    }
+    return true;
+}
+
+bool ShowBundle::open(const QString &path)
+{
+    close();
+    error.clear();
+    file.reset(new QFile(path));
+    if (!file->open(QIODevice::ReadOnly))
+        return fail(file->errorString());
+
+    quint64 length = file->size();
+    if (length < pageSize)
+        return fail(QObject::tr("file is truncated"));
+    const uchar *base = file->map(0, length);
+    if (!base)
+        return fail(file->errorString());
+
+    QDataStream in(file.data());
+    in.setVersion(streamVersion);
+    quint32 magic, version, width, height;
+    quint64 metadataOffset, metadataSize;
+    in >> magic >> version >> width >> height >> metadataOffset >> metadataSize;
+    if (magic != bundleMagic)
+        return fail(QObject::tr("not a show bundle"));
+    if (version != bundleVersion)
+        return fail(QObject::tr("unsupported bundle version %1").arg(version));
+    if (metadataOffset > length || metadataSize > length - metadataOffset)
+        return fail(QObject::tr("file is truncated"));
+
+    file->seek(metadataOffset);
+    quint32 count;
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        Item item;
+        qint32 dwell;
+        quint64 offset;
+        quint32 w, h, bpl;
+        in >> item.filename >> dwell >> offset >> w >> h >> bpl;
+        item.dwellSeconds = dwell;
+        if (offset) {
+            // In 64 bits, and without sums that could wrap around.
+            if (offset % pageSize || w == 0 || h == 0 || bpl > INT_MAX
+                    || h > INT_MAX || quint64(bpl) < quint64(w) * 4
+                    || offset > metadataOffset
+                    || quint64(bpl) * h > metadataOffset - offset)
+                return fail(QObject::tr("frame %1 is out of bounds").arg(i));
+            // The mapping is read-only; Qt copies frames that get written to.
+            item.frame = QImage(base + offset, int(w), int(h), int(bpl),
+                                frameFormat, releaseMapping,
+                                new QSharedPointer<QFile>(file));
+            frames.insert(item.filename, item.frame);
+        }
+        itemList.append(item);
+    }
+    in >> count;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++) {
+        QSharedPointer<Countdown> c(new Countdown);
+        c->readStream(in);
+        countdownList.append(c);
+    }
+    if (in.status() != QDataStream::Ok)
+        return fail(QObject::tr("metadata is corrupt"));
+
+    size = QSize(int(width), int(height));
+    mappedMemory.set(qint64(length));
+    return true;
+}
+
+void ShowBundle::close()
+{
+    itemList.clear();
+    countdownList.clear();
+    frames.clear();
+    file.reset();
+    size = QSize();
+    mappedMemory.set(0);
+}
+
+bool ShowBundle::isOpen() const
+{
+    return !file.isNull();
+}
+
+QString ShowBundle::errorString() const
+{
+    return error;
+}
+
+QSize ShowBundle::outputSize() const
+{
+    return size;
+}
+
+// Pre-scaled frames are only usable on an output of the size they were
+// exported for; anything else would mean rescaling on every paint.
+bool ShowBundle::matches(const QSize &outputSize) const
+{
+    return isOpen() && size == outputSize;
+}
+
+QList<ShowBundle::Item> ShowBundle::items() const
+{
+    return itemList;
+}
+
+QList<QSharedPointer<Countdown>> ShowBundle::countdowns() const
+{
+    return countdownList;
+}
+
+QImage ShowBundle::frame(const QString &filename) const
+{
+    return frames.value(filename);
+}
+
+bool ShowBundle::fail(const QString &message)
+{
+    close();
+    error = message;
+    return false;
+}
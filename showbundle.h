@@ -0,0 +1,86 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef SHOWBUNDLE_H
+#define SHOWBUNDLE_H
+
+#include <functional>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QSharedPointer>
+#include <QSize>
+#include "common.h"
+#include "memorybudget.h"
+
+// A packed show: playlist entries, countdowns and stills pre-scaled to the
+// output size.  Frames are stored page aligned in the painter's native
+// format so that an opened bundle hands out QImages pointing straight into
+// the memory-mapped file.
+//
+// Layout: a header page, then one page-aligned frame per still, then a
+// QDataStream metadata block.  The header is
+//     quint32 magic, quint32 version, quint32 width, quint32 height,
+//     quint64 metadataOffset, quint64 metadataSize
+// and each metadata item is
+//     QString filename, qint32 dwellSeconds, quint64 frameOffset,
+//     quint32 width, quint32 height, quint32 bytesPerLine
+// with a zero frameOffset for entries (such as videos) without a frame.
+class ShowBundle
+{
+public:
+    struct Item {
+        QString filename;
+        int dwellSeconds = 0;
+        QImage frame;
+    };
+
+    ShowBundle();
+
+    // Frames are requested one at a time so that only one is held in memory;
+    // returning false from prepareFrame abandons the export.
+    typedef std::function<bool(const Item &item, QImage *frame)> FrameFunction;
+    static bool write(const QString &path, const QSize &outputSize,
+                      const QList<Item> &items,
+                      const QList<QSharedPointer<Countdown>> &countdowns,
+                      const FrameFunction &prepareFrame,
+                      QString *error = nullptr);
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const;
+    QString errorString() const;
+
+    QSize outputSize() const;
+    bool matches(const QSize &outputSize) const;
+    QList<Item> items() const;
+    QList<QSharedPointer<Countdown>> countdowns() const;
+    QImage frame(const QString &filename) const;
+
+private:
+    bool fail(const QString &message);
+
+    QSharedPointer<QFile> file;
+    QSize size;
+    QList<Item> itemList;
+    QList<QSharedPointer<Countdown>> countdownList;
+    QHash<QString,QImage> frames;
+    QString error;
+    MemoryBudget::Account mappedMemory { MemoryBudget::BundleMapping };
+};
+
+#endif // SHOWBUNDLE_H
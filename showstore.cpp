@@ -0,0 +1,396 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QDataStream>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+#include "showstore.h"
+#include "trace.h"
+
+constexpr quint32 journalMagic = 0x50524a31;    // "PRJ1"
+constexpr QDataStream::Version streamVersion = QDataStream::Qt_5_6;
+constexpr int compactSlack = 32;
+// Long enough to cover a drop of many files with one sync.
+constexpr int syncDelayMsec = 100;
+
+// Each record is framed as [quint32 length][quint16 checksum][payload].
+constexpr int recordHeaderSize = 6;
+
+static QByteArray frameRecord(const QByteArray &payload)
+{
+    QByteArray record;
+    QDataStream out(&record, QIODevice::WriteOnly);
+    out.setVersion(streamVersion);
+    out << quint32(payload.size())
+        << qChecksum(payload.constData(), uint(payload.size()));
+    record.append(payload);
+    return record;
+}
+
+static QByteArray journalHeader()
+{
+    QByteArray header;
+    QDataStream out(&header, QIODevice::WriteOnly);
+    out << journalMagic;
+    return header;
+}
+
+ShowStore::ShowStore(const QString &path) : path(path), journal(path)
+{
+    syncTimer.setSingleShot(true);
+    syncTimer.setInterval(syncDelayMsec);
+    QObject::connect(&syncTimer, &QTimer::timeout, [this]() { sync(); });
+}
+
+ShowStore::~ShowStore()
+{
+    sync();
+    journal.close();
+}
+
+bool ShowStore::exists() const
+{
+    return QFileInfo::exists(path);
+}
+
+bool ShowStore::load()
+{
+    countdownData.clear();
+    imageData.clear();
+    imageOrder.clear();
+    cueData.clear();
+    cueOrder.clear();
+    records = 0;
+    sync();
+    journal.close();
+
+    QFile in(path);
+    if (in.open(QIODevice::ReadOnly)) {
+        QByteArray data = in.readAll();
+        in.close();
+        QDataStream header(data);
+        quint32 magic = 0;
+        header >> magic;
+        if (magic != journalMagic) {
+            // Kept for inspection, and replaced below by an empty journal
+            // so that new records are not appended after a bad header.
+            QString aside = path + ".bad";
+            qWarning() << "show store: moving unrecognised journal" << path
+                       << "to" << aside;
+            QFile::remove(aside);
+            if (!QFile::rename(path, aside))
+                QFile::remove(path);
+            data.clear();
+        }
+
+        // Replay until the first torn or corrupt record; a crash can only
+        // have damaged the tail.
+        int pos = sizeof(journalMagic);
+        while (pos + recordHeaderSize <= data.size()) {
+            QDataStream frame(data.mid(pos, recordHeaderSize));
+            frame.setVersion(streamVersion);
+            quint32 length;
+            quint16 checksum;
+            frame >> length >> checksum;
+            if (length > uint(data.size() - pos - recordHeaderSize))
+                break;
+            QByteArray payload = data.mid(pos + recordHeaderSize, int(length));
+            if (qChecksum(payload.constData(), length) != checksum)
+                break;
+            apply(payload);
+            records++;
+            pos += recordHeaderSize + int(length);
+        }
+        if (!data.isEmpty() && pos < data.size()) {
+            qWarning() << "show store: discarding" << data.size() - pos
+                       << "damaged bytes at the end of" << path;
+            QFile::resize(path, pos);
+        }
+    }
+
+    if (records > 2 * liveCount() + compactSlack || !exists())
+        compact();
+    return openForAppend();
+}
+
+QList<QSharedPointer<Countdown>> ShowStore::countdowns() const
+{
+    QList<QSharedPointer<Countdown>> list;
+    for (auto i = countdownData.constBegin(); i != countdownData.constEnd(); ++i) {
+        QSharedPointer<Countdown> c(new Countdown);
+        QDataStream in(i.value());
+        in.setVersion(streamVersion);
+        c->readStream(in);
+        c->storeId = i.key();
+        list.append(c);
+    }
+    return list;
+}
+
+QList<ShowStore::Image> ShowStore::images() const
+{
+    QList<Image> list;
+    for (quint32 id : imageOrder)
+        list.append(imageData.value(id));
+    return list;
+}
+
+QList<Cue> ShowStore::cues() const
+{
+    QList<Cue> list;
+    for (quint32 id : cueOrder) {
+        Cue cue;
+        QDataStream in(cueData.value(id));
+        in.setVersion(streamVersion);
+        cue.readStream(in);
+        cue.storeId = id;
+        list.append(cue);
+    }
+    return list;
+}
+
+quint32 ShowStore::putCountdown(const Countdown &c)
+{
+    quint32 id = c.storeId ? c.storeId : nextId;
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(streamVersion);
+    out << quint8(PutCountdown) << id;
+    c.writeStream(out);
+    append(payload);
+    return id;
+}
+
+quint32 ShowStore::putImage(quint32 id, const QString &filename, int dwellSeconds)
+{
+    if (!id)
+        id = nextId;
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(streamVersion);
+    out << quint8(PutImage) << id << filename << qint32(dwellSeconds);
+    append(payload);
+    return id;
+}
+
+void ShowStore::remove(quint32 id)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out << quint8(Remove) << id;
+    append(payload);
+}
+
+void ShowStore::clearCountdowns()
+{
+    append(QByteArray(1, char(ClearCountdowns)));
+}
+
+void ShowStore::clearImages()
+{
+    append(QByteArray(1, char(ClearImages)));
+}
+
+void ShowStore::setImageOrder(const QList<quint32> &ids)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(streamVersion);
+    out << quint8(ImageOrder) << ids;
+    append(payload);
+}
+
+quint32 ShowStore::putCue(const Cue &cue)
+{
+    quint32 id = cue.storeId ? cue.storeId : nextId;
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(streamVersion);
+    out << quint8(PutCue) << id;
+    cue.writeStream(out);
+    append(payload);
+    return id;
+}
+
+void ShowStore::clearCues()
+{
+    append(QByteArray(1, char(ClearCues)));
+}
+
+// Rewrite the journal as the minimal set of records for the live state.
+void ShowStore::compact()
+{
+    TRACE_SPAN("store.compact");
+    journal.close();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        qWarning() << "show store: cannot write" << path << out.errorString();
+        return;
+    }
+    out.write(journalHeader());
+    int written = 0;
+    for (auto i = countdownData.constBegin(); i != countdownData.constEnd(); ++i) {
+        QByteArray payload;
+        QDataStream s(&payload, QIODevice::WriteOnly);
+        s.setVersion(streamVersion);
+        s << quint8(PutCountdown) << i.key();
+        payload.append(i.value());
+        out.write(frameRecord(payload));
+        written++;
+    }
+    for (quint32 id : imageOrder) {
+        const Image &image = imageData[id];
+        QByteArray payload;
+        QDataStream s(&payload, QIODevice::WriteOnly);
+        s.setVersion(streamVersion);
+        s << quint8(PutImage) << id << image.filename << qint32(image.dwellSeconds);
+        out.write(frameRecord(payload));
+        written++;
+    }
+    for (quint32 id : cueOrder) {
+        QByteArray payload;
+        QDataStream s(&payload, QIODevice::WriteOnly);
+        s.setVersion(streamVersion);
+        s << quint8(PutCue) << id;
+        payload.append(cueData[id]);
+        out.write(frameRecord(payload));
+        written++;
+    }
+    if (!out.commit()) {
+        qWarning() << "show store: compaction failed" << out.errorString();
+        return;
+    }
+    records = written;
+}
+
+void ShowStore::apply(const QByteArray &payload)
+{
+    QDataStream in(payload);
+    in.setVersion(streamVersion);
+    quint8 op;
+    quint32 id = 0;
+    in >> op;
+
+    switch (op) {
+    case PutCountdown:
+        in >> id;
+        countdownData.insert(id, payload.mid(1 + sizeof(id)));
+        break;
+    case PutImage: {
+        Image image;
+        qint32 dwell;
+        in >> id >> image.filename >> dwell;
+        image.id = id;
+        image.dwellSeconds = dwell;
+        if (!imageData.contains(id))
+            imageOrder.append(id);
+        imageData.insert(id, image);
+        break;
+    }
+    case Remove:
+        in >> id;
+        countdownData.remove(id);
+        if (imageData.remove(id))
+            imageOrder.removeOne(id);
+        if (cueData.remove(id))
+            cueOrder.removeOne(id);
+        break;
+    case ClearCountdowns:
+        countdownData.clear();
+        break;
+    case ClearImages:
+        imageData.clear();
+        imageOrder.clear();
+        break;
+    case ImageOrder: {
+        QList<quint32> ids;
+        in >> ids;
+        imageOrder.clear();
+        for (quint32 i : ids)
+            if (imageData.contains(i))
+                imageOrder.append(i);
+        break;
+    }
+    case PutCue:
+        in >> id;
+        if (!cueData.contains(id))
+            cueOrder.append(id);
+        cueData.insert(id, payload.mid(1 + sizeof(id)));
+        break;
+    case ClearCues:
+        cueData.clear();
+        cueOrder.clear();
+        break;
+    default:
+        qWarning() << "show store: unknown record" << op;
+    }
+    nextId = std::max(nextId, id + 1);
+}
+
+void ShowStore::append(const QByteArray &payload)
+{
+    TRACE_SPAN("store.append");
+    apply(payload);
+    records++;
+    if (!journal.isOpen() && !openForAppend())
+        return;
+
+    journal.write(frameRecord(payload));
+    journal.flush();
+    if (!syncTimer.isActive())
+        syncTimer.start();
+
+    if (records > 2 * liveCount() + compactSlack) {
+        compact();
+        openForAppend();
+    }
+}
+
+void ShowStore::sync()
+{
+    syncTimer.stop();
+    if (!journal.isOpen())
+        return;
+    TRACE_SPAN("store.sync");
+#ifdef Q_OS_UNIX
+    ::fdatasync(journal.handle());
+#endif
+}
+
+bool ShowStore::openForAppend()
+{
+    if (journal.isOpen())
+        return true;
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qWarning() << "show store: cannot open" << path << journal.errorString();
+        return false;
+    }
+    if (journal.size() == 0)
+        journal.write(journalHeader());
+    return true;
+}
+
+int ShowStore::liveCount() const
+{
+    return countdownData.size() + imageData.size() + cueData.size();
+}
@@ -0,0 +1,86 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef SHOWSTORE_H
+#define SHOWSTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QSharedPointer>
+#include <QTimer>
+#include "common.h"
+
+// Append-only journal of countdown, playlist and cue list edits.  Every
+// edit is written as one checksummed record when it happens, so a crash
+// loses at most the record being written.  Records are synced to disk in
+// batches shortly afterwards, so a power cut loses at most the last tenth
+// of a second of edits.  The journal is rewritten as a
+// snapshot once dead records outnumber live ones, which keeps loading
+// proportional to the number of live items.
+class ShowStore
+{
+public:
+    struct Image {
+        quint32 id;
+        QString filename;
+        int dwellSeconds;
+    };
+
+    explicit ShowStore(const QString &path);
+    ~ShowStore();
+
+    bool exists() const;
+    bool load();
+    QList<QSharedPointer<Countdown>> countdowns() const;
+    QList<Image> images() const;
+    QList<Cue> cues() const;
+
+    quint32 putCountdown(const Countdown &c);
+    quint32 putImage(quint32 id, const QString &filename, int dwellSeconds);
+    void remove(quint32 id);
+    void clearCountdowns();
+    void clearImages();
+    void setImageOrder(const QList<quint32> &ids);
+    quint32 putCue(const Cue &cue);
+    void clearCues();
+    void compact();
+
+private:
+    enum Op : quint8 { PutCountdown = 1, PutImage, Remove, ClearCountdowns,
+                       ClearImages, ImageOrder, PutCue, ClearCues };
+
+    void apply(const QByteArray &payload);
+    void append(const QByteArray &payload);
+    bool openForAppend();
+    void sync();
+    int liveCount() const;
+
+    QString path;
+    QFile journal;
+    quint32 nextId = 1;
+    int records = 0;
+    QTimer syncTimer;
+
+    QMap<quint32,QByteArray> countdownData;
+    QMap<quint32,Image> imageData;
+    QList<quint32> imageOrder;
+    QMap<quint32,QByteArray> cueData;
+    QList<quint32> cueOrder;
+};
+
+#endif // SHOWSTORE_H
@@ -0,0 +1,230 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QDebug>
+#include "displaywidget.h"
+#include "slideshow.h"
+
+// A transition starting more than one 60Hz frame after its deadline is late.
+constexpr qint64 lateToleranceMsec = 1000/60;
+
+Slideshow::Slideshow(DisplayWidget *display, QObject *parent)
+    : QObject(parent), display(display)
+{
+    // Coarse timers may fire 5% late, which would count as late transitions.
+    dwellTimer.setSingleShot(true);
+    dwellTimer.setTimerType(Qt::PreciseTimer);
+    connect(&dwellTimer, &QTimer::timeout,
+            this, &Slideshow::dwellTimer_timeout);
+    connect(display, &DisplayWidget::dismissed, this, &Slideshow::stop);
+}
+
+Slideshow::~Slideshow()
+{
+    decodeJob.cancel();
+}
+
+void Slideshow::setItems(const QList<Item> &items)
+{
+    this->items = items;
+}
+
+void Slideshow::setDwell(int msec)
+{
+    dwellMsec = std::max(msec, 1);
+}
+
+void Slideshow::setLoop(bool loop)
+{
+    this->loop = loop;
+}
+
+void Slideshow::setCrossfade(bool crossfade)
+{
+    this->crossfade = crossfade;
+}
+
+bool Slideshow::isRunning() const
+{
+    return running;
+}
+
+int Slideshow::overruns() const
+{
+    return overrunCount;
+}
+
+int Slideshow::lateFrames() const
+{
+    return lateCount + display->lateFrames() - lateFramesAtStart;
+}
+
+QString Slideshow::statsText() const
+{
+    return tr("%1 overruns, %2 late frames").arg(overruns()).arg(lateFrames());
+}
+
+void Slideshow::start(int index)
+{
+    if (items.isEmpty())
+        return;
+    running = true;
+    waiting = true;
+    current = -1;
+    preparedIndex = -1;
+    failures = 0;
+    overrunCount = 0;
+    lateCount = 0;
+    lateFramesAtStart = display->lateFrames();
+    dwellTimer.stop();
+    emit statsChanged();
+    prepare(std::min(std::max(index, 0), items.count() - 1));
+}
+
+void Slideshow::stop()
+{
+    if (!running)
+        return;
+    running = false;
+    waiting = false;
+    dwellTimer.stop();
+    decodeJob.cancel();
+    preparedImage = QImage();
+    preparedMemory.set(0);
+    qInfo() << "slideshow stopped:" << statsText();
+    emit finished();
+}
+
+void Slideshow::dwellTimer_timeout()
+{
+    if (pendingIndex < 0) {
+        display->stop();
+        stop();
+        return;
+    }
+    if (nextReady()) {
+        showPrepared();
+        return;
+    }
+    // Hold the current slide until the next one has been decoded, which
+    // is now holding up the output.
+    overrunCount++;
+    waiting = true;
+    emit statsChanged();
+    decode(JobScheduler::OnAir);
+}
+
+void Slideshow::imagePrepared(const QImage &image)
+{
+    if (!running)
+        return;
+
+    preparedImage = image;
+    preparedMemory.set(preparedImage.sizeInBytes());
+    if (preparedImage.isNull()) {
+        qWarning() << "slideshow: could not decode" << items[pendingIndex].filename;
+        if (++failures >= items.count()) {
+            stop();
+            return;
+        }
+        prepare(nextIndex(pendingIndex));
+        return;
+    }
+    failures = 0;
+    preparedIndex = pendingIndex;
+    if (waiting)
+        showPrepared();
+}
+
+int Slideshow::nextIndex(int index) const
+{
+    if (index + 1 < items.count())
+        return index + 1;
+    return loop ? 0 : -1;
+}
+
+int Slideshow::dwellFor(int index) const
+{
+    int msec = items[index].dwellMsec;
+    return msec > 0 ? msec : dwellMsec;
+}
+
+bool Slideshow::nextReady() const
+{
+    return pendingIndex >= 0 && preparedIndex == pendingIndex;
+}
+
+void Slideshow::prepare(int index)
+{
+    decodeJob.cancel();
+    pendingIndex = index;
+    preparedIndex = -1;
+    preparedImage = QImage();
+    preparedMemory.set(0);
+    if (index < 0)
+        return;
+
+    const QString &filename = items[index].filename;
+    if (!items[index].frame.isNull()) {
+        preparedIndex = index;
+        preparedImage = items[index].frame;
+        preparedMemory.set(preparedImage.sizeInBytes());
+        if (waiting)
+            showPrepared();
+        return;
+    }
+    if (DisplayWidget::isMediaFile(filename)) {
+        // mpv opens videos itself; there is nothing to decode ahead of time.
+        preparedIndex = index;
+        if (waiting)
+            showPrepared();
+        return;
+    }
+    decode(waiting ? JobScheduler::OnAir : JobScheduler::NextUp);
+}
+
+// Asking again at a higher priority joins the decode already queued.
+void Slideshow::decode(JobScheduler::Priority priority)
+{
+    JobScheduler::Handle previous = decodeJob;
+    decodeJob = DisplayWidget::prepareImageJob(priority, items[pendingIndex].filename,
+                                               display->contentSize(), this,
+                                               [this](const QImage &image) {
+        imagePrepared(image);
+    });
+    previous.cancel();
+}
+
+void Slideshow::showPrepared()
+{
+    if (current >= 0 && !waiting
+            && dwellClock.elapsed() - dwellFor(current) > lateToleranceMsec) {
+        lateCount++;
+        emit statsChanged();
+    }
+    waiting = false;
+
+    current = preparedIndex;
+    if (preparedImage.isNull())
+        display->displayFile(items[current].filename);
+    else
+        display->displayImage(preparedImage, crossfade);
+    emit itemShown(current);
+
+    dwellClock.start();
+    dwellTimer.start(dwellFor(current));
+    prepare(nextIndex(current));
+}
@@ -0,0 +1,98 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef SLIDESHOW_H
+#define SLIDESHOW_H
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include "jobscheduler.h"
+#include "memorybudget.h"
+
+class DisplayWidget;
+
+class Slideshow : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Item {
+        QString filename;
+        int dwellMsec = 0;  // 0 uses the slideshow default
+        QImage frame;       // already prepared, e.g. from a show bundle
+    };
+
+    explicit Slideshow(DisplayWidget *display, QObject *parent = nullptr);
+    ~Slideshow();
+
+    void setItems(const QList<Item> &items);
+    void setDwell(int msec);
+    void setLoop(bool loop);
+    void setCrossfade(bool crossfade);
+
+    bool isRunning() const;
+    int overruns() const;
+    int lateFrames() const;
+    QString statsText() const;
+
+signals:
+    void itemShown(int index);
+    void statsChanged();
+    void finished();
+
+public slots:
+    void start(int index = 0);
+    void stop();
+
+private slots:
+    void dwellTimer_timeout();
+
+private:
+    int nextIndex(int index) const;
+    int dwellFor(int index) const;
+    bool nextReady() const;
+    void prepare(int index);
+    void decode(JobScheduler::Priority priority);
+    void imagePrepared(const QImage &image);
+    void showPrepared();
+
+    DisplayWidget *display;
+    QList<Item> items;
+    int dwellMsec = 5000;
+    bool loop = true;
+    bool crossfade = true;
+
+    bool running = false;
+    bool waiting = false;
+    int current = -1;
+    int pendingIndex = -1;
+    int preparedIndex = -1;
+    int failures = 0;
+    QImage preparedImage;
+    MemoryBudget::Account preparedMemory { MemoryBudget::SlideshowImages };
+    JobScheduler::Handle decodeJob;
+
+    QTimer dwellTimer;
+    QElapsedTimer dwellClock;
+    int overrunCount = 0;
+    int lateCount = 0;
+    int lateFramesAtStart = 0;
+};
+
+#endif // SLIDESHOW_H
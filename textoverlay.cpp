@@ -0,0 +1,298 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <algorithm>
+#include <QEvent>
+#include <QFontMetricsF>
+#include <QLocale>
+#include <QPainter>
+#include <QStaticText>
+#include <QTime>
+#include <QtMath>
+#include "displaywidget.h"
+#include "textoverlay.h"
+#include "trace.h"
+
+TextOverlay::TextOverlay(QWidget *parent) : QWidget(parent)
+{
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setAttribute(Qt::WA_NoSystemBackground);
+    setGeometry(parent->rect());
+    parent->installEventFilter(this);
+
+    animationTimer.setInterval(DisplayWidget::updateMsec);
+    connect(&animationTimer, &QTimer::timeout, this, &TextOverlay::animate);
+    clockTimer.setInterval(1000);
+    connect(&clockTimer, &QTimer::timeout, this, &TextOverlay::clock_timeout);
+}
+
+TextOverlay::~TextOverlay()
+{
+    if (source)
+        source->mirrors.removeOne(this);
+    for (TextOverlay *m : mirrors)
+        m->source = nullptr;
+}
+
+void TextOverlay::setText(Block block, const QString &text)
+{
+    Item &item = items[block];
+    if (item.text == text)
+        return;
+    item.text = text;
+    if (!text.isEmpty()) {
+        // Changed text replaces the old at once; only showing and hiding
+        // the block fades.
+        item.shownText = text;
+        item.layoutSize = QSize();
+        updateBlock(block);
+    }
+    if (!animationTimer.isActive()) {
+        animationClock.start();
+        animationTimer.start();
+    }
+}
+
+QString TextOverlay::text(Block block) const
+{
+    return items[block].text;
+}
+
+void TextOverlay::setClockVisible(bool visible)
+{
+    if (visible) {
+        clockTimer.start();
+        clock_timeout();
+    } else {
+        clockTimer.stop();
+        setText(Clock, QString());
+    }
+}
+
+bool TextOverlay::isClockVisible() const
+{
+    return clockTimer.isActive();
+}
+
+// A mirror draws the source's blocks, scaled to its own output area.
+void TextOverlay::setSource(TextOverlay *source)
+{
+    if (this->source)
+        this->source->mirrors.removeOne(this);
+    this->source = source;
+    if (source)
+        source->mirrors.append(this);
+    update();
+}
+
+void TextOverlay::setTile(const QSize &canvas, const QRect &tile)
+{
+    this->canvas = canvas;
+    this->tile = tile;
+    update();
+}
+
+void TextOverlay::paintBlocks(QPainter &p, const QRect &area) const
+{
+    TRACE_SPAN("paint.overlay");
+    for (int b = 0; b < BlockCount; b++) {
+        const Item &item = items[b];
+        if (item.shownText.isEmpty() || item.level <= 0.0)
+            continue;
+        QRect r = blockRect(Block(b), area);
+        if (r.isEmpty())
+            continue;
+        p.save();
+        p.setOpacity(p.opacity() * item.level);
+        p.setRenderHint(QPainter::SmoothPixmapTransform);
+        p.drawPixmap(r, item.pixmap);
+        p.restore();
+    }
+}
+
+void TextOverlay::paintEvent(QPaintEvent *e)
+{
+    Q_UNUSED(e);
+    const TextOverlay &shown = source ? *source : *this;
+    QRect area = outputArea();
+    for (int b = 0; b < BlockCount; b++)
+        items[b].painted = shown.items[b].shownText.isEmpty()
+                ? QRect() : shown.blockRect(Block(b), area);
+    QPainter p(this);
+    shown.paintBlocks(p, area);
+}
+
+bool TextOverlay::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == parentWidget() && event->type() == QEvent::Resize)
+        setGeometry(parentWidget()->rect());
+    return QWidget::eventFilter(watched, event);
+}
+
+void TextOverlay::animate()
+{
+    double step = animationClock.restart() / double(DisplayWidget::fadeTimeMsec);
+    bool moving = false;
+    for (int b = 0; b < BlockCount; b++) {
+        Item &item = items[b];
+        double target = item.text.isEmpty() ? 0.0 : 1.0;
+        if (item.level == target && (target > 0.0 || item.shownText.isEmpty()))
+            continue;
+        if (target > item.level)
+            item.level = std::min(item.level + step, target);
+        else
+            item.level = std::max(item.level - step, target);
+        updateBlock(Block(b));
+        if (item.level <= 0.0) {
+            item.shownText.clear();
+            item.pixmap = QPixmap();
+            item.layoutSize = QSize();
+            accountPixmaps();
+        }
+        moving = moving || item.level != target;
+    }
+    if (!moving)
+        animationTimer.stop();
+}
+
+void TextOverlay::clock_timeout()
+{
+    setText(Clock, QLocale().toString(QTime::currentTime(), QLocale::ShortFormat));
+}
+
+// Lays the block out for an output of the given size; text is sized
+// relative to a 1080 line output.
+void TextOverlay::rasterize(Block block, const QSize &area) const
+{
+    Item &item = items[block];
+    if (item.layoutSize == area)
+        return;
+    TRACE_SPAN("overlay.rasterize");
+    item.layoutSize = area;
+    item.pixmap = QPixmap();
+    accountPixmaps();
+    if (item.shownText.isEmpty() || area.isEmpty())
+        return;
+
+    qreal unit = area.height() / 1080.0;
+    qreal pad = 16 * unit;
+    qreal maxWidth = area.width() * (block == Caption ? 0.8 : 0.6) - 2 * pad;
+    QTextOption option;
+    option.setAlignment(block == Caption ? Qt::AlignHCenter : Qt::AlignLeft);
+    option.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+
+    QStringList lines = item.shownText.split('\n');
+    QList<QStaticText> texts;
+    QList<QFont> fonts;
+    qreal width = 0;
+    qreal height = 0;
+    for (int i = 0; i < lines.count(); i++) {
+        QFont f;
+        bool title = block == LowerThird && i > 0;
+        f.setPixelSize(std::max(qRound((title ? 32 : 44) * unit), 1));
+        f.setBold(block != Caption && !title);
+        QStaticText t(lines[i]);
+        t.setTextFormat(Qt::PlainText);
+        t.setTextOption(option);
+        if (QFontMetricsF(f).size(Qt::TextSingleLine, lines[i]).width() > maxWidth)
+            t.setTextWidth(maxWidth);
+        t.prepare(QTransform(), f);
+        width = std::max(width, t.size().width());
+        height += t.size().height();
+        texts.append(t);
+        fonts.append(f);
+    }
+
+    QSizeF size(width + 2 * pad, height + 2 * pad);
+    qreal scale = devicePixelRatioF();
+    item.pixmap = QPixmap(qCeil(size.width() * scale), qCeil(size.height() * scale));
+    item.pixmap.setDevicePixelRatio(scale);
+    item.pixmap.fill(Qt::transparent);
+    QPainter p(&item.pixmap);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(0, 0, 0, 160));
+    p.drawRoundedRect(QRectF(QPointF(), size), 8 * unit, 8 * unit);
+    p.setPen(Qt::white);
+    qreal y = pad;
+    for (int i = 0; i < texts.count(); i++) {
+        qreal x = pad;
+        if (block == Caption)
+            x += (width - texts[i].size().width()) / 2;
+        p.setFont(fonts[i]);
+        p.drawStaticText(QPointF(x, y), texts[i]);
+        y += texts[i].size().height();
+    }
+    accountPixmaps();
+}
+
+void TextOverlay::accountPixmaps() const
+{
+    qint64 bytes = 0;
+    for (const Item &item : items)
+        bytes += qint64(item.pixmap.width()) * item.pixmap.height()
+                * item.pixmap.depth() / 8;
+    pixmapMemory.set(bytes);
+}
+
+// Where the block is drawn in the given output area, including the slide
+// of a lower third that is fading.
+QRect TextOverlay::blockRect(Block block, const QRect &area) const
+{
+    const Item &item = items[block];
+    rasterize(block, outputArea().size());
+    if (item.pixmap.isNull())
+        return QRect();
+    qreal scale = area.height() / qreal(item.layoutSize.height());
+    QSizeF size = QSizeF(item.pixmap.size()) / item.pixmap.devicePixelRatioF() * scale;
+    qreal w = area.width();
+    qreal h = area.height();
+    QPointF at;
+    switch (block) {
+    case LowerThird: {
+        qreal slide = (1.0 - item.level) * (1.0 - item.level) * w * 0.03;
+        at = QPointF(w * 0.05 - slide, h * 0.85 - size.height());
+        break;
+    }
+    case Caption:
+        at = QPointF((w - size.width()) / 2, h * 0.95 - size.height());
+        break;
+    default:
+        at = QPointF(w * 0.97 - size.width(), h * 0.03);
+    }
+    return QRectF(at + area.topLeft(), size).toAlignedRect();
+}
+
+QRect TextOverlay::dirtyRect(Block block) const
+{
+    const TextOverlay &shown = source ? *source : *this;
+    QRect r = items[block].painted;
+    if (!shown.items[block].shownText.isEmpty())
+        r |= shown.blockRect(block, outputArea());
+    return r;
+}
+
+void TextOverlay::updateBlock(Block block)
+{
+    update(dirtyRect(block));
+    for (TextOverlay *m : mirrors)
+        m->update(m->dirtyRect(block));
+}
+
+QRect TextOverlay::outputArea() const
+{
+    return canvas.isEmpty() ? rect() : QRect(-tile.topLeft(), canvas);
+}
@@ -0,0 +1,90 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef TEXTOVERLAY_H
+#define TEXTOVERLAY_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QPixmap>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+#include "memorybudget.h"
+
+// Lower thirds, captions and a clock drawn over whatever the output shows.
+// Each block is laid out with QStaticText and rasterized into a pixmap once
+// per change of text or output size; frames in between only draw the
+// pixmaps.  Blocks fade in and out independently, and repaint no more than
+// their own rectangles.  The layer ignores input.
+class TextOverlay : public QWidget
+{
+    Q_OBJECT
+public:
+    enum Block { LowerThird, Caption, Clock, BlockCount };
+
+    explicit TextOverlay(QWidget *parent);
+    ~TextOverlay();
+
+    // A lower third's first line is the name, further lines the title.
+    // Empty text fades the block out.
+    void setText(Block block, const QString &text);
+    QString text(Block block) const;
+    void setClockVisible(bool visible);
+    bool isClockVisible() const;
+
+    void setSource(TextOverlay *source);
+    void setTile(const QSize &canvas, const QRect &tile);
+    void paintBlocks(QPainter &p, const QRect &area) const;
+
+protected:
+    void paintEvent(QPaintEvent *e) Q_DECL_OVERRIDE;
+    bool eventFilter(QObject *watched, QEvent *event) Q_DECL_OVERRIDE;
+
+private slots:
+    void animate();
+    void clock_timeout();
+
+private:
+    struct Item {
+        QString text;           // what the block should show
+        QString shownText;      // what the pixmap holds, kept while fading out
+        QPixmap pixmap;
+        QSize layoutSize;       // output size the pixmap was laid out for
+        double level = 0.0;     // 0 hidden, 1 fully in
+        QRect painted;          // in this widget, at the last paint
+    };
+
+    void rasterize(Block block, const QSize &area) const;
+    void accountPixmaps() const;
+    QRect blockRect(Block block, const QRect &area) const;
+    QRect dirtyRect(Block block) const;
+    void updateBlock(Block block);
+    QRect outputArea() const;
+
+    mutable Item items[BlockCount];
+    mutable MemoryBudget::Account pixmapMemory { MemoryBudget::OverlayPixmaps };
+    QTimer animationTimer;
+    QElapsedTimer animationClock;
+    QTimer clockTimer;
+
+    QPointer<TextOverlay> source;
+    QList<TextOverlay*> mirrors;
+    QSize canvas;
+    QRect tile;
+};
+
+#endif // TEXTOVERLAY_H
@@ -0,0 +1,116 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QThread>
+#include "trace.h"
+
+namespace Trace {
+
+std::atomic<bool> recording { false };
+thread_local std::atomic<const char*> currentSpan { nullptr };
+static std::atomic<std::atomic<const char*>*> mainSpan { nullptr };
+
+constexpr quint64 ringSize = 1 << 16;
+
+struct Event {
+    const char *name;
+    qint64 start;
+    qint64 end;
+    quintptr thread;
+};
+
+static Event ring[ringSize];
+static std::atomic<quint64> ringHead { 0 };
+
+static const QElapsedTimer &clock()
+{
+    static QElapsedTimer timer;
+    static bool started = (timer.start(), true);
+    Q_UNUSED(started);
+    return timer;
+}
+
+void setRecording(bool on)
+{
+    clock();
+    if (on && !recording)
+        ringHead = 0;
+    recording = on;
+}
+
+void setMainThread()
+{
+    mainSpan = &currentSpan;
+}
+
+const char *mainThreadSpan()
+{
+    std::atomic<const char*> *span = mainSpan.load();
+    return span ? span->load(std::memory_order_relaxed) : nullptr;
+}
+
+qint64 now()
+{
+    return clock().nsecsElapsed();
+}
+
+void record(const char *name, qint64 start, qint64 end)
+{
+    quint64 slot = ringHead.fetch_add(1, std::memory_order_relaxed) % ringSize;
+    ring[slot] = { name, start, end,
+                   reinterpret_cast<quintptr>(QThread::currentThreadId()) };
+}
+
+// Events still being written while saving may come out torn; that is an
+// acceptable price for keeping the recording side lock-free.
+bool save(const QString &filename)
+{
+    quint64 head = ringHead.load();
+    quint64 first = head > ringSize ? head - ringSize : 0;
+    qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray events;
+    for (quint64 i = first; i < head; i++) {
+        const Event &e = ring[i % ringSize];
+        if (!e.name)
+            continue;
+        events.append(QJsonObject {
+            { "name", e.name },
+            { "ph", "X" },
+            { "ts", e.start / 1000.0 },
+            { "dur", (e.end - e.start) / 1000.0 },
+            { "pid", pid },
+            { "tid", qint64(e.thread) }
+        });
+    }
+    QJsonObject doc {
+        { "traceEvents", events },
+        { "displayTimeUnit", "ms" }
+    };
+
+    QFile f(filename);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+    return f.write(QJsonDocument(doc).toJson(QJsonDocument::Compact)) >= 0;
+}
+
+}
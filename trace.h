@@ -0,0 +1,69 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <QString>
+
+// Scoped trace spans recorded into a fixed-size ring buffer and saved as
+// Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev).  Span names
+// must be string literals.  While recording is off a span only notes its
+// name as the thread's in-flight operation, for the stall watchdog.
+namespace Trace {
+
+extern std::atomic<bool> recording;
+extern thread_local std::atomic<const char*> currentSpan;
+
+void setRecording(bool on);
+bool save(const QString &filename);
+
+void setMainThread();
+const char *mainThreadSpan();
+
+qint64 now();
+void record(const char *name, qint64 start, qint64 end);
+
+class Span
+{
+public:
+    explicit Span(const char *name)
+        : name(recording.load(std::memory_order_relaxed) ? name : nullptr),
+          start(this->name ? now() : 0),
+          parent(currentSpan.exchange(name, std::memory_order_relaxed)) { }
+    ~Span()
+    {
+        currentSpan.store(parent, std::memory_order_relaxed);
+        if (name)
+            record(name, start, now());
+    }
+    Span(const Span &) = delete;
+    Span &operator=(const Span &) = delete;
+
+private:
+    const char *name;
+    qint64 start;
+    const char *parent;
+};
+
+}
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SPAN(name) Trace::Span TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,84 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include "trace.h"
+#include "videomirror.h"
+#include "videowidget.h"
+
+VideoMirror::VideoMirror(QWidget *parent) : QOpenGLWidget(parent)
+{
+
+}
+
+VideoMirror::~VideoMirror()
+{
+    makeCurrent();
+    if (blitter.isCreated())
+        blitter.destroy();
+}
+
+void VideoMirror::setSource(VideoWidget *source)
+{
+    disconnect(frameConnection);
+    this->source = source;
+    if (source)
+        frameConnection = connect(source, &VideoWidget::mirrorFrameReady,
+                                  this, QOverload<>::of(&VideoMirror::update));
+    update();
+}
+
+// The source renders the whole canvas; a tiled mirror shows its part.
+void VideoMirror::setTile(const QSize &canvas, const QRect &tile)
+{
+    this->canvas = canvas;
+    this->tile = tile;
+    update();
+}
+
+void VideoMirror::paintGL()
+{
+    TRACE_SPAN("mirror.paintGL");
+    QOpenGLFunctions *gl = context()->functions();
+    gl->glClearColor(0, 0, 0, 1);
+    gl->glClear(GL_COLOR_BUFFER_BIT);
+    if (!source || !source->mirrorTexture())
+        return;
+    if (!blitter.isCreated())
+        blitter.create();
+
+    qreal scale = devicePixelRatioF();
+    QRect area(0, 0, int(width()*scale), int(height()*scale));
+    QSize textureSize = source->mirrorSize();
+    QRect fit = area;
+    QRectF part(QPointF(), textureSize);
+    if (canvas.isEmpty()) {
+        fit.setSize(textureSize.scaled(area.size(), Qt::KeepAspectRatio));
+        fit.moveCenter(area.center());
+    } else {
+        qreal sx = textureSize.width() / qreal(canvas.width());
+        qreal sy = textureSize.height() / qreal(canvas.height());
+        part = QRectF(tile.x() * sx, tile.y() * sy,
+                      tile.width() * sx, tile.height() * sy);
+    }
+    blitter.bind();
+    blitter.blit(source->mirrorTexture(),
+                 QOpenGLTextureBlitter::targetTransform(fit, area),
+                 QOpenGLTextureBlitter::sourceTransform(
+                     part, textureSize, QOpenGLTextureBlitter::OriginBottomLeft));
+    blitter.release();
+}
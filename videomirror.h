@@ -0,0 +1,50 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef VIDEOMIRROR_H
+#define VIDEOMIRROR_H
+
+#include <QOpenGLTextureBlitter>
+#include <QOpenGLWidget>
+#include <QPointer>
+
+class VideoWidget;
+
+// Shows the frames of a mirrored VideoWidget on another output.  The
+// texture is shared between contexts (Qt::AA_ShareOpenGLContexts), so a
+// mirror only draws it and never decodes anything itself.
+class VideoMirror : public QOpenGLWidget
+{
+    Q_OBJECT
+public:
+    explicit VideoMirror(QWidget *parent = nullptr);
+    ~VideoMirror();
+
+    void setSource(VideoWidget *source);
+    void setTile(const QSize &canvas, const QRect &tile);
+
+protected:
+    void paintGL() Q_DECL_OVERRIDE;
+
+private:
+    QPointer<VideoWidget> source;
+    QMetaObject::Connection frameConnection;
+    QSize canvas;
+    QRect tile;
+    QOpenGLTextureBlitter blitter;
+};
+
+#endif // VIDEOMIRROR_H
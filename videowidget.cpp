@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <cstring>
+#include <QDebug>
 #include <QMouseEvent>
 #include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
 #include <QTimer>
+#include "trace.h"
 #include "videowidget.h"
 
 static const char cmdLoadFile[] = "loadfile";
@@ -9,21 +13,44 @@ static const char cmdStop[] = "stop";
 static const char msgMpvCreateException[] = "could not create mpv context";
 static const char msgMpvInitializeException[] = "could not initialize mpv context";
 static const char msgRenderContextException[] = "failed to initialize mpv GL context";
+static const char propCache[] = "cache";
+static const char propCacheBufferingState[] = "cache-buffering-state";
+static const char propCachePauseWait[] = "cache-pause-wait";
+static const char propCacheSecs[] = "cache-secs";
 static const char propDScale[] = "dscale";
+static const char propDemuxerCacheDuration[] = "demuxer-cache-duration";
+static const char propDemuxerCacheState[] = "demuxer-cache-state";
+static const char propDemuxerMaxBackBytes[] = "demuxer-max-back-bytes";
+static const char propDemuxerMaxBytes[] = "demuxer-max-bytes";
+static const char propDemuxerReadaheadSecs[] = "demuxer-readahead-secs";
 static const char propDuration[] = "duration";
+static const char propEnd[] = "end";
 static const char propEofReached[] = "eof-reached";
+static const char propHrSeek[] = "hr-seek";
 static const char propHwdec[] = "hwdec";
 static const char propKeepOpen[] = "keep-open";
+static const char propLoopFile[] = "loop-file";
 static const char propPause[] = "pause";
+static const char propPausedForCache[] = "paused-for-cache";
+static const char propStart[] = "start";
 static const char propTimePos[] = "time-pos";
+static const char propVideoBitrate[] = "video-bitrate";
 static const char propVolume[] = "volume";
 static const char value0[] = "0";
 static const char value100[] = "100";
 static const char valueAuto[] = "auto";
+static const char valueInf[] = "inf";
 static const char valueNo[] = "no";
+static const char valueNone[] = "none";
 static const char valueYes[] = "yes";
 static const char valueSpline36[] = "spline36";
 
+QString VideoWidget::videoOutput = "libmpv";
+
+// Under memory pressure the cache is halved down to the floor, and the
+// back buffer kept at a third of it.
+constexpr qint64 minimumCacheBytes = 8 * 1024 * 1024;
+
 static void mpvWakeUp(void *ctx)
 {
     QMetaObject::invokeMethod((VideoWidget*)ctx, "handleMpvEvents",
@@ -39,6 +66,27 @@ static void *getGlProcAddress(void *ctx, const char *name)
     return reinterpret_cast<void*>(glCtx->getProcAddress(QByteArray(name)));
 }
 
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+#ifndef GL_MAP_READ_BIT
+#define GL_MAP_READ_BIT 0x0001
+#endif
+
+// Pixel pack buffers mapped with glMapBufferRange need desktop GL 3.0 (or
+// the ARB extension) or GLES 3.  GLES 2 reads back synchronously.
+static bool supportsAsyncReadback(QOpenGLContext *ctx)
+{
+    QSurfaceFormat format = ctx->format();
+    if (ctx->isOpenGLES())
+        return format.majorVersion() >= 3;
+    return format.version() >= qMakePair(3, 0)
+            || ctx->hasExtension("GL_ARB_map_buffer_range");
+}
+
 VideoWidget::VideoWidget(QWidget *parent) : QOpenGLWidget(parent)
 {
     setCursor(Qt::PointingHandCursor);
@@ -48,20 +96,39 @@ VideoWidget::VideoWidget(QWidget *parent) : QOpenGLWidget(parent)
         throw std::runtime_error(msgMpvCreateException);
     if (mpv_initialize(mpv) < 0)
         throw std::runtime_error(msgMpvInitializeException);
-    mpv_set_option_string(mpv, "vo", "libmpv");
+    mpv_set_option_string(mpv, "vo", videoOutput.toUtf8().constData());
     mpv_set_option_string(mpv, propHwdec, valueAuto);
     mpv_set_option_string(mpv, propKeepOpen, valueYes);
     mpv_set_option_string(mpv, propDScale, valueSpline36);
+    mpv_set_option_string(mpv, propHrSeek, valueYes);
     mpv_observe_property(mpv, 0, propDuration, MPV_FORMAT_DOUBLE);
     mpv_observe_property(mpv, 0, propEofReached, MPV_FORMAT_FLAG);
     mpv_observe_property(mpv, 0, propPause, MPV_FORMAT_FLAG);
     mpv_observe_property(mpv, 0, propTimePos, MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, 0, propDemuxerCacheState, MPV_FORMAT_NODE);
+    mpv_observe_property(mpv, 0, propDemuxerCacheDuration, MPV_FORMAT_DOUBLE);
+    mpv_observe_property(mpv, 0, propPausedForCache, MPV_FORMAT_FLAG);
+    mpv_observe_property(mpv, 0, propCacheBufferingState, MPV_FORMAT_INT64);
+    mpv_observe_property(mpv, 0, propVideoBitrate, MPV_FORMAT_DOUBLE);
     mpv_set_wakeup_callback(mpv, mpvWakeUp, this);
+
+    MemoryBudget *budget = MemoryBudget::instance();
+    if (budget->underPressure())
+        setCacheLimit(minimumCacheBytes);
+    connect(budget, &MemoryBudget::pressure, this, &VideoWidget::shrinkCache);
+    connect(budget, &MemoryBudget::relieved, this, &VideoWidget::restoreCache);
 }
 
 VideoWidget::~VideoWidget()
 {
     makeCurrent();
+    overlay.release();
+    for (Readback &r : readbacks)
+        if (r.buffer)
+            context()->functions()->glDeleteBuffers(1, &r.buffer);
+    frameFbo.reset();
+    if (blitter.isCreated())
+        blitter.destroy();
     if (mpvGL) {
         mpv_render_context_free(mpvGL);
         mpvGL = nullptr;
@@ -85,18 +152,165 @@ void VideoWidget::setEarlyStopMode(bool earlyStop)
     earlyStopMode = earlyStop;
 }
 
-void VideoWidget::play(QString url)
+// Draws a countdown over the video until clearOverlay().  The overlay is
+// drawn whenever a frame is, so the caller should update() at least once a
+// second while the video is paused.
+void VideoWidget::setCountdownOverlay(const QDateTime &endTime, qint64 msecDuration)
+{
+    overlayEnd = endTime;
+    overlayDuration = msecDuration;
+    update();
+}
+
+void VideoWidget::clearOverlay()
+{
+    if (!hasOverlay())
+        return;
+    overlayDuration = 0;
+    update();
+}
+
+bool VideoWidget::hasOverlay() const
+{
+    return overlayDuration > 0;
+}
+
+// While mirrored, frames are rendered once into a texture shared with the
+// other outputs' contexts, and mirrorFrameReady() tells them to draw it.
+void VideoWidget::setMirrored(bool mirrored)
+{
+    this->mirrored = mirrored;
+    update();
+}
+
+// A tiled widget renders the whole canvas offscreen and shows its tile.
+void VideoWidget::setTile(const QSize &canvas, const QRect &tile)
+{
+    this->canvas = canvas;
+    this->tile = tile;
+    update();
+}
+
+void VideoWidget::setFrameSink(const FrameSink &sink)
+{
+    frameSink = sink;
+    readbackFrame = QImage();
+    for (Readback &r : readbacks)
+        r.pending = false;
+    accountBuffers();
+}
+
+GLuint VideoWidget::mirrorTexture() const
+{
+    return frameFbo ? frameFbo->texture() : 0;
+}
+
+QSize VideoWidget::mirrorSize() const
 {
-    if (!glInitialized) {
+    return frameFbo ? frameFbo->size() : QSize();
+}
+
+// The demuxer cache also bounds local playback.  Streams read ahead up to
+// readaheadSecs, and after an underrun mpv holds the last frame until
+// prebufferSecs are buffered again.
+void VideoWidget::setStreamCache(const StreamCache &cache)
+{
+    streamCache = cache;
+    QString readahead = QString::number(cache.readaheadSecs);
+    mpvSetProperty(propDemuxerReadaheadSecs, readahead);
+    mpvSetProperty(propCacheSecs, readahead);
+    mpvSetProperty(propCachePauseWait, QString::number(cache.prebufferSecs));
+    if (!MemoryBudget::instance()->underPressure())
+        setCacheLimit(cache.bytes);
+}
+
+QString VideoWidget::streamStatsText() const
+{
+    return statsText;
+}
+
+void VideoWidget::setVideoOutput(const QString &vo)
+{
+    videoOutput = vo;
+}
+
+void VideoWidget::play(QString url, bool loop)
+{
+    if (!glInitialized && usesRenderApi()) {
         pendingFileOpen = url;
+        pendingPaused = false;
+        pendingLoop = loop;
+        pendingStream = false;
         return;
     }
+    streaming = false;
+    prebuffering = false;
+    updateStreamStats();
+    setRange(0, 0);
+    mpvSetProperty(propLoopFile, loop ? valueInf : valueNo);
+    mpvSetProperty(propCache, valueAuto);
     mpvCommand({cmdLoadFile, url});
     mpvSetProperty(propPause, valueNo);
 }
 
+// Opens a network stream paused, and starts it once the cache holds the
+// pre-buffer, so that it does not stutter straight after being shown.
+// streamReady() is emitted as playback starts; streamFailed() if the
+// stream could not be opened before then.
+void VideoWidget::playStream(QString url)
+{
+    if (!glInitialized && usesRenderApi()) {
+        pendingFileOpen = url;
+        pendingPaused = false;
+        pendingStream = true;
+        return;
+    }
+    streaming = true;
+    prebuffering = true;
+    updateStreamStats();
+    mpvSetProperty(propPause, valueYes);
+    setRange(0, 0);
+    mpvSetProperty(propLoopFile, valueNo);
+    mpvSetProperty(propCache, valueYes);
+    mpvCommand({cmdLoadFile, url});
+}
+
+// Opens the file paused on its first frame, or on the frame at msecIn,
+// ready for resume().  The seek is precise and happens while loading, so
+// it costs nothing once the cue is taken.  Playback ends at msecOut.
+void VideoWidget::cue(QString url, qint64 msecIn, qint64 msecOut)
+{
+    if (!glInitialized && usesRenderApi()) {
+        pendingFileOpen = url;
+        pendingPaused = true;
+        pendingIn = msecIn;
+        pendingOut = msecOut;
+        pendingStream = false;
+        return;
+    }
+    streaming = false;
+    prebuffering = false;
+    updateStreamStats();
+    mpvSetProperty(propPause, valueYes);
+    setRange(msecIn, msecOut);
+    mpvSetProperty(propLoopFile, valueNo);
+    mpvSetProperty(propCache, valueAuto);
+    mpvCommand({cmdLoadFile, url});
+}
+
+void VideoWidget::resume()
+{
+    if (!pendingFileOpen.isEmpty())
+        pendingPaused = false;
+    else
+        mpvSetProperty(propPause, valueNo);
+}
+
 void VideoWidget::stop()
 {
+    streaming = false;
+    prebuffering = false;
+    updateStreamStats();
     mpvCommand({cmdStop});
     mpvCommand({cmdLoadFile, ""});
 }
@@ -108,6 +322,8 @@ void VideoWidget::pauseResume()
 
 void VideoWidget::initializeGL()
 {
+    if (!usesRenderApi())
+        return;
     mpv_opengl_init_params glInitParams {
         getGlProcAddress, nullptr, nullptr
     };
@@ -120,11 +336,17 @@ void VideoWidget::initializeGL()
         throw std::runtime_error(msgRenderContextException);
     mpv_render_context_set_update_callback(mpvGL, VideoWidget::onMpvGLUpdate,
                                            reinterpret_cast<void*>(this));
+    asyncReadback = supportsAsyncReadback(context());
 
     glInitialized = true;
     if (!pendingFileOpen.isEmpty()) {
         QTimer::singleShot(100, this, [this] {
-            play(pendingFileOpen);
+            if (pendingPaused)
+                cue(pendingFileOpen, pendingIn, pendingOut);
+            else if (pendingStream)
+                playStream(pendingFileOpen);
+            else
+                play(pendingFileOpen, pendingLoop);
             pendingFileOpen.clear();
         });
     }
@@ -132,10 +354,24 @@ void VideoWidget::initializeGL()
 
 void VideoWidget::paintGL()
 {
+    TRACE_SPAN("paintGL");
+    if (!mpvGL)
+        return;
     qreal scale = devicePixelRatioF();
+    QSize size = (canvas.isEmpty() ? this->size() : canvas) * scale;
+    QRect shown = canvas.isEmpty() ? QRect(QPoint(), size)
+                                   : QRect(tile.topLeft() * scale, tile.size() * scale);
+    bool offscreen = mirrored || !canvas.isEmpty();
+    GLuint target = defaultFramebufferObject();
+    if (offscreen) {
+        if (!frameFbo || frameFbo->size() != size)
+            frameFbo.reset(new QOpenGLFramebufferObject(size));
+        target = frameFbo->handle();
+    } else {
+        frameFbo.reset();
+    }
     mpv_opengl_fbo mpvFbo {
-        static_cast<int>(defaultFramebufferObject()),
-        int(width()*scale), int(height()*scale), 0
+        static_cast<int>(target), size.width(), size.height(), 0
     };
     int flipY = 1;
 
@@ -146,6 +382,106 @@ void VideoWidget::paintGL()
     };
 
     mpv_render_context_render(mpvGL, renderParams);
+    QOpenGLFunctions *gl = context()->functions();
+    if (hasOverlay()) {
+        qint64 msecLeft = QDateTime::currentDateTime().msecsTo(overlayEnd);
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, target);
+        overlay.paint(size, msecLeft, overlayDuration);
+    }
+    if (frameSink)
+        exportFrame(target, size);
+    accountBuffers();
+    if (offscreen) {
+        if (!blitter.isCreated())
+            blitter.create();
+        QRect area(QPoint(), shown.size());
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebufferObject());
+        gl->glViewport(0, 0, area.width(), area.height());
+        blitter.bind();
+        blitter.blit(frameFbo->texture(),
+                     QOpenGLTextureBlitter::targetTransform(area, area),
+                     QOpenGLTextureBlitter::sourceTransform(
+                         shown, size, QOpenGLTextureBlitter::OriginBottomLeft));
+        blitter.release();
+    }
+    if (mirrored) {
+        // Make the frame visible to the mirrors' contexts before they draw.
+        gl->glFlush();
+        emit mirrorFrameReady();
+    }
+    if (playbackRestarted) {
+        playbackRestarted = false;
+        emit frameRendered();
+    }
+}
+
+// Where it can, each frame is read into one of two pixel pack buffers and
+// the previous frame's buffer, which has had a frame's time to fill, is
+// handed on instead; shared frames then lag the output by one frame.
+// Otherwise the read is synchronous, which stalls until the frame is drawn.
+void VideoWidget::exportFrame(GLuint target, const QSize &size)
+{
+    int bytesPerLine = size.width() * 4;
+    if (!asyncReadback) {
+        TRACE_SPAN("export.readPixels");
+        QOpenGLFunctions *gl = context()->functions();
+        if (readbackFrame.size() != size)
+            readbackFrame = QImage(size, QImage::Format_RGBA8888_Premultiplied);
+        gl->glBindFramebuffer(GL_FRAMEBUFFER, target);
+        gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        gl->glReadPixels(0, 0, size.width(), size.height(),
+                         GL_RGBA, GL_UNSIGNED_BYTE, readbackFrame.bits());
+        frameSink(readbackFrame);
+        return;
+    }
+
+    TRACE_SPAN("export.readback");
+    QOpenGLExtraFunctions *gl = context()->extraFunctions();
+    Readback &current = readbacks[readbackIndex];
+    if (!current.buffer)
+        gl->glGenBuffers(1, &current.buffer);
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, current.buffer);
+    if (current.size != size) {
+        gl->glBufferData(GL_PIXEL_PACK_BUFFER, bytesPerLine * size.height(),
+                         nullptr, GL_STREAM_READ);
+        current.size = size;
+    }
+    gl->glBindFramebuffer(GL_FRAMEBUFFER, target);
+    gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl->glReadPixels(0, 0, size.width(), size.height(),
+                     GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    current.pending = true;
+
+    readbackIndex ^= 1;
+    Readback &previous = readbacks[readbackIndex];
+    if (previous.pending) {
+        previous.pending = false;
+        int previousBytesPerLine = previous.size.width() * 4;
+        int bytes = previousBytesPerLine * previous.size.height();
+        gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, previous.buffer);
+        void *pixels = gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes,
+                                            GL_MAP_READ_BIT);
+        if (pixels) {
+            frameSink(QImage(static_cast<const uchar*>(pixels), previous.size.width(),
+                             previous.size.height(), previousBytesPerLine,
+                             QImage::Format_RGBA8888_Premultiplied));
+            gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+    }
+    gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+// The offscreen frame, the pixel pack buffers and the synchronous readback
+// image; GL memory, but usually shared with the process on integrated GPUs.
+void VideoWidget::accountBuffers()
+{
+    qint64 bytes = readbackFrame.sizeInBytes();
+    if (frameFbo)
+        bytes += qint64(frameFbo->width()) * frameFbo->height() * 4;
+    for (const Readback &r : readbacks)
+        if (r.buffer)
+            bytes += qint64(r.size.width()) * r.size.height() * 4;
+    bufferMemory.set(bytes);
 }
 
 void VideoWidget::mousePressEvent(QMouseEvent *event)
@@ -156,6 +492,7 @@ void VideoWidget::mousePressEvent(QMouseEvent *event)
 
 void VideoWidget::handleMpvEvents()
 {
+    TRACE_SPAN("handleMpvEvents");
     while (mpv) {
         mpv_event *event = mpv_wait_event(mpv, 0);
         if (event->event_id == MPV_EVENT_NONE) {
@@ -194,9 +531,52 @@ void VideoWidget::handleMpvEvent(mpv_event *event)
                 bool flag = *(bool*)prop->data;
                 mpvPaused = flag;
             }
+        } else if (!strcmp(prop->name, propDemuxerCacheState)) {
+            readCacheState(prop->format == MPV_FORMAT_NODE
+                           ? (mpv_node*)prop->data : nullptr);
+        } else if (!strcmp(prop->name, propDemuxerCacheDuration)) {
+            cacheSeconds = prop->format == MPV_FORMAT_DOUBLE
+                    ? *(double*)prop->data : 0;
+            if (prebuffering && cacheSeconds >= streamCache.prebufferSecs)
+                finishPrebuffer();
+            updateStreamStats();
+        } else if (!strcmp(prop->name, propPausedForCache)) {
+            // mpv pauses by itself on an underrun; the last frame stays up.
+            pausedForCache = prop->format == MPV_FORMAT_FLAG
+                    && *(int*)prop->data;
+            updateStreamStats();
+        } else if (!strcmp(prop->name, propCacheBufferingState)) {
+            bufferPercent = prop->format == MPV_FORMAT_INT64
+                    ? *(int64_t*)prop->data : 0;
+            updateStreamStats();
+        } else if (!strcmp(prop->name, propVideoBitrate)) {
+            videoBitrate = prop->format == MPV_FORMAT_DOUBLE
+                    ? *(double*)prop->data : 0;
+            updateStreamStats();
+        }
+        break;
+    }
+    case MPV_EVENT_FILE_LOADED:
+        emit fileLoaded();
+        break;
+    case MPV_EVENT_END_FILE: {
+        mpv_event_end_file *end = (mpv_event_end_file*)event->data;
+        if (prebuffering && end->reason == MPV_END_FILE_REASON_ERROR) {
+            qWarning().noquote() << QString("Stream failed to open: %1")
+                                    .arg(mpv_error_string(end->error));
+            streaming = false;
+            prebuffering = false;
+            updateStreamStats();
+            emit streamFailed();
         }
         break;
     }
+    case MPV_EVENT_PLAYBACK_RESTART:
+        if (usesRenderApi())
+            playbackRestarted = true;
+        else
+            emit frameRendered();
+        break;
     default:
         ;
     }
@@ -216,6 +596,7 @@ void VideoWidget::maybeUpdate()
 
 void VideoWidget::mpvCommand(const QStringList &params)
 {
+    TRACE_SPAN("mpvCommand");
     int n = params.count();
     char *args[n+1];
     QList<QByteArray> data;
@@ -234,6 +615,103 @@ void VideoWidget::mpvSetProperty(const QString &name, const QString &value)
     mpv_set_property_string(mpv, cName.data(), cValue.data());
 }
 
+void VideoWidget::shrinkCache()
+{
+    qint64 limit = cacheLimit ? cacheLimit : streamCache.bytes;
+    setCacheLimit(std::max(limit / 2, minimumCacheBytes));
+}
+
+void VideoWidget::restoreCache()
+{
+    if (cacheLimit)
+        setCacheLimit(streamCache.bytes);
+}
+
+// start and end apply to the next file loaded.
+void VideoWidget::setRange(qint64 msecIn, qint64 msecOut)
+{
+    auto seconds = [](qint64 msec) {
+        return msec > 0 ? QString::number(msec / 1000.0, 'f', 3) : QString(valueNone);
+    };
+    mpvSetProperty(propStart, seconds(msecIn));
+    mpvSetProperty(propEnd, seconds(msecOut));
+}
+
+void VideoWidget::setCacheLimit(qint64 bytes)
+{
+    if (bytes == cacheLimit)
+        return;
+    cacheLimit = bytes;
+    mpvSetProperty(propDemuxerMaxBytes, QString::number(bytes));
+    mpvSetProperty(propDemuxerMaxBackBytes, QString::number(bytes / 3));
+}
+
+void VideoWidget::readCacheState(const mpv_node *state)
+{
+    qint64 total = 0;
+    qint64 forward = 0;
+    bool eof = false;
+    inputRate = 0;
+    if (state && state->format == MPV_FORMAT_NODE_MAP) {
+        const mpv_node_list *map = state->u.list;
+        for (int i = 0; i < map->num; i++) {
+            const mpv_node &value = map->values[i];
+            if (value.format == MPV_FORMAT_FLAG) {
+                if (!strcmp(map->keys[i], "eof"))
+                    eof = value.u.flag;
+                continue;
+            }
+            if (value.format != MPV_FORMAT_INT64)
+                continue;
+            if (!strcmp(map->keys[i], "total-bytes"))
+                total = value.u.int64;
+            else if (!strcmp(map->keys[i], "fw-bytes"))
+                forward = value.u.int64;
+            else if (!strcmp(map->keys[i], "raw-input-rate"))
+                inputRate = value.u.int64;
+        }
+    }
+    // Older mpv only reports the forward part of the cache.
+    cacheMemory.set(total ? total : forward);
+    // A stream shorter than the pre-buffer is ready once it is all read.
+    if (prebuffering && eof)
+        finishPrebuffer();
+    updateStreamStats();
+}
+
+void VideoWidget::finishPrebuffer()
+{
+    prebuffering = false;
+    mpvSetProperty(propPause, valueNo);
+    emit streamReady();
+}
+
+void VideoWidget::updateStreamStats()
+{
+    QString text;
+    if (streaming && prebuffering) {
+        double wanted = std::max(streamCache.prebufferSecs, 0.1);
+        text = tr("Stream: buffering %1%")
+                .arg(std::min(int(cacheSeconds * 100 / wanted), 100));
+    } else if (streaming && pausedForCache) {
+        text = tr("Stream: underrun, buffering %1%").arg(bufferPercent);
+    } else if (streaming) {
+        text = tr("Stream: %1 s buffered, %2 Mbit/s video, %3 Mbit/s in")
+                .arg(cacheSeconds, 0, 'f', 1)
+                .arg(videoBitrate / 1e6, 0, 'f', 1)
+                .arg(inputRate * 8 / 1e6, 0, 'f', 1);
+    }
+    if (text == statsText)
+        return;
+    statsText = text;
+    emit streamStatsChanged();
+}
+
+bool VideoWidget::usesRenderApi()
+{
+    return videoOutput == "libmpv";
+}
+
 void VideoWidget::onMpvGLUpdate(void *ctx)
 {
     QMetaObject::invokeMethod((VideoWidget*)ctx,
@@ -1,9 +1,17 @@
 #ifndef VIDEOWIDGET_H
 #define VIDEOWIDGET_H
 
+#include <functional>
+#include <QDateTime>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTextureBlitter>
 #include <QOpenGLWidget>
+#include <QScopedPointer>
 #include <mpv/client.h>
 #include <mpv/render_gl.h>
+#include "common.h"
+#include "countdownoverlay.h"
+#include "memorybudget.h"
 
 class QMouseEvent;
 
@@ -16,14 +24,41 @@ public:
 
     void setSilentMode(bool silent);
     void setEarlyStopMode(bool earlyStop);
+    void setCountdownOverlay(const QDateTime &endTime, qint64 msecDuration);
+    void clearOverlay();
+    bool hasOverlay() const;
+    void setMirrored(bool mirrored);
+    void setTile(const QSize &canvas, const QRect &tile);
+    // Receives each rendered frame, read back at the rendered size as
+    // premultiplied RGBA with the bottom row first.  The image is only
+    // valid during the call.
+    typedef std::function<void(const QImage &frame)> FrameSink;
+    void setFrameSink(const FrameSink &sink);
+    GLuint mirrorTexture() const;
+    QSize mirrorSize() const;
+    void setStreamCache(const StreamCache &cache);
+    QString streamStatsText() const;
+
+    // Anything other than "libmpv" (e.g. "null" or "image") renders without
+    // a GL context, which lets headless tools play media.
+    static void setVideoOutput(const QString &vo);
 
 signals:
     void durationChanged(double time);
     void positionChanged(double time);
     void eofReached();
+    void fileLoaded();
+    void frameRendered();
+    void mirrorFrameReady();
+    void streamReady();
+    void streamFailed();
+    void streamStatsChanged();
 
 public slots:
-    void play(QString url);
+    void play(QString url, bool loop = false);
+    void playStream(QString url);
+    void cue(QString url, qint64 msecIn = 0, qint64 msecOut = 0);
+    void resume();
     void stop();
     void pauseResume();
 
@@ -36,20 +71,71 @@ private slots:
     void handleMpvEvents();
     void handleMpvEvent(mpv_event *event);
     void maybeUpdate();
+    void shrinkCache();
+    void restoreCache();
 
 private:
     void mpvCommand(const QStringList &params);
     void mpvSetProperty(const QString &name, const QString &value);
+    void setCacheLimit(qint64 bytes);
+    void setRange(qint64 msecIn, qint64 msecOut);
+    void readCacheState(const mpv_node *state);
+    void finishPrebuffer();
+    void updateStreamStats();
+    void exportFrame(GLuint target, const QSize &size);
+    void accountBuffers();
     static void onMpvGLUpdate(void *ctx);
+    static bool usesRenderApi();
+
+    static QString videoOutput;
 
     mpv_handle *mpv = nullptr;
     mpv_render_context *mpvGL = nullptr;
 
     QString pendingFileOpen;
+    bool pendingPaused = false;
+    bool pendingLoop = false;
+    bool pendingStream = false;
+    qint64 pendingIn = 0;
+    qint64 pendingOut = 0;
+    qint64 cacheLimit = 0;
+    MemoryBudget::Account cacheMemory { MemoryBudget::MpvDemuxer };
+    StreamCache streamCache;
+
+    bool streaming = false;
+    bool prebuffering = false;
+    bool pausedForCache = false;
+    int bufferPercent = 0;
+    double cacheSeconds = 0;
+    double videoBitrate = 0;
+    qint64 inputRate = 0;
+    QString statsText;
+
+    CountdownOverlay overlay;
+    QDateTime overlayEnd;
+    qint64 overlayDuration = 0;
+
+    bool mirrored = false;
+    QSize canvas;
+    QRect tile;
+    FrameSink frameSink;
+    QImage readbackFrame;
+    struct Readback {
+        GLuint buffer = 0;
+        QSize size;
+        bool pending = false;
+    };
+    Readback readbacks[2];
+    int readbackIndex = 0;
+    bool asyncReadback = false;
+    QScopedPointer<QOpenGLFramebufferObject> frameFbo;
+    MemoryBudget::Account bufferMemory { MemoryBudget::GlBuffers };
+    QOpenGLTextureBlitter blitter;
 
     bool earlyStopMode = false;
     bool glInitialized = false;
     bool mpvPaused = false;
+    bool playbackRestarted = false;
 };
 
 #endif // VIDEOWIDGET_H
@@ -0,0 +1,192 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#include <QDebug>
+#include <QElapsedTimer>
+#include "trace.h"
+#include "watchdog.h"
+
+#ifdef Q_OS_LINUX
+#include <csignal>
+#include <execinfo.h>
+#include <pthread.h>
+
+// The GUI thread is interrupted with a signal and walks its own stack; the
+// frames are symbolised afterwards on the watchdog thread.
+static constexpr int maxFrames = 48;
+static void *sampleFrames[maxFrames];
+static std::atomic<int> sampleDepth { -1 };
+static pthread_t guiThread;
+
+static void sampleHandler(int)
+{
+    sampleDepth = backtrace(sampleFrames, maxFrames);
+}
+#endif
+
+Watchdog::Watchdog(QObject *parent) : QThread(parent)
+{
+    Trace::setMainThread();
+#ifdef Q_OS_LINUX
+    guiThread = pthread_self();
+    // backtrace() loads libgcc on first use, which is not signal safe.
+    backtrace(sampleFrames, 1);
+    struct sigaction sa = {};
+    sa.sa_handler = sampleHandler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR2, &sa, nullptr);
+#endif
+}
+
+Watchdog::~Watchdog()
+{
+    requestInterruption();
+    wait();
+}
+
+void Watchdog::setThreshold(int msec)
+{
+    thresholdMsec = msec;
+}
+
+int Watchdog::threshold() const
+{
+    return thresholdMsec;
+}
+
+qint64 Watchdog::beats() const
+{
+    QMutexLocker lock(&mutex);
+    return beatCount;
+}
+
+qint64 Watchdog::maxLag() const
+{
+    QMutexLocker lock(&mutex);
+    return lagMax;
+}
+
+double Watchdog::meanLag() const
+{
+    QMutexLocker lock(&mutex);
+    return beatCount ? double(lagTotal) / beatCount : 0;
+}
+
+int Watchdog::stalls() const
+{
+    QMutexLocker lock(&mutex);
+    return stallCount;
+}
+
+Watchdog::Stall Watchdog::lastStall() const
+{
+    QMutexLocker lock(&mutex);
+    return last;
+}
+
+QString Watchdog::statsText() const
+{
+    QMutexLocker lock(&mutex);
+    QString text = tr("Event loop lag: %1 ms mean, %2 ms max, %3 stalls")
+            .arg(beatCount ? double(lagTotal) / beatCount : 0, 0, 'f', 1)
+            .arg(lagMax).arg(stallCount);
+    if (stallCount)
+        text += tr(" (last %1 ms in %2)").arg(last.msec).arg(last.operation);
+    return text;
+}
+
+void Watchdog::run()
+{
+    QElapsedTimer clock;
+    clock.start();
+    while (!isInterruptionRequested()) {
+        qint64 sent = clock.nsecsElapsed();
+        answered = false;
+        QMetaObject::invokeMethod(this, [this, clock, sent]() {
+            beat(clock.nsecsElapsed() - sent);
+        }, Qt::QueuedConnection);
+
+        bool sampled = false;
+        while (!answered && !isInterruptionRequested()) {
+            msleep(pollMsec);
+            qint64 lag = (clock.nsecsElapsed() - sent) / 1000000;
+            if (!sampled && lag >= thresholdMsec) {
+                sampled = true;
+                const char *span = Trace::mainThreadSpan();
+                QStringList stack = sampleGuiThread();
+                QMutexLocker lock(&mutex);
+                pending.operation = span ? span : "event loop";
+                pending.stack = stack;
+            }
+        }
+        msleep(intervalMsec);
+    }
+}
+
+// Runs on the GUI thread once the beat is dispatched.
+void Watchdog::beat(qint64 lagNsec)
+{
+    qint64 lag = lagNsec / 1000000;
+    bool stall = false;
+    Stall s;
+    {
+        QMutexLocker lock(&mutex);
+        beatCount++;
+        lagTotal += lag;
+        lagMax = qMax(lagMax, lag);
+        if (lag >= thresholdMsec && !pending.operation.isEmpty()) {
+            stall = true;
+            stallCount++;
+            pending.msec = lag;
+            last = s = pending;
+        }
+        pending = Stall();
+    }
+    answered = true;
+
+    if (stall) {
+        qWarning().noquote() << QString("Event loop stalled for %1 ms in %2")
+                                .arg(s.msec).arg(s.operation);
+        for (const QString &frame : s.stack)
+            qWarning().noquote() << "    " << frame;
+        emit stalled(s.msec, s.operation);
+    }
+    emit statsChanged();
+}
+
+QStringList Watchdog::sampleGuiThread()
+{
+    QStringList frames;
+#ifdef Q_OS_LINUX
+    sampleDepth = -1;
+    if (pthread_kill(guiThread, SIGUSR2) != 0)
+        return frames;
+    for (int i = 0; i < 20 && sampleDepth < 0; i++)
+        msleep(1);
+    int depth = sampleDepth;
+    if (depth <= 0)
+        return frames;
+    char **symbols = backtrace_symbols(sampleFrames, depth);
+    if (!symbols)
+        return frames;
+    // Skip the handler and the signal trampoline.
+    for (int i = 2; i < depth; i++)
+        frames.append(QString::fromLocal8Bit(symbols[i]));
+    free(symbols);
+#endif
+    return frames;
+}
@@ -0,0 +1,79 @@
+/* This file is part of Presenter.
+ *
+ * Presenter is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Presenter is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with Presenter; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <atomic>
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+
+// Heartbeats the GUI event loop from a separate thread and measures how
+// long each beat waits to be dispatched.  A beat still waiting after the
+// threshold is a stall: the span the GUI thread is inside (see trace.h) and,
+// on Linux, a stack sample of the GUI thread are logged.
+class Watchdog : public QThread
+{
+    Q_OBJECT
+public:
+    struct Stall {
+        qint64 msec = 0;
+        QString operation;
+        QStringList stack;
+    };
+
+    // Must be constructed on the GUI thread.
+    explicit Watchdog(QObject *parent = nullptr);
+    ~Watchdog();
+
+    void setThreshold(int msec);
+    int threshold() const;
+
+    qint64 beats() const;
+    qint64 maxLag() const;
+    double meanLag() const;
+    int stalls() const;
+    Stall lastStall() const;
+    QString statsText() const;
+
+signals:
+    void statsChanged();
+    void stalled(qint64 msec, const QString &operation);
+
+protected:
+    void run() override;
+
+private:
+    void beat(qint64 sentNsec);
+    QStringList sampleGuiThread();
+
+    static constexpr int intervalMsec = 100;
+    static constexpr int pollMsec = 5;
+
+    std::atomic<int> thresholdMsec { 250 };
+    std::atomic<bool> answered { true };
+
+    mutable QMutex mutex;
+    qint64 beatCount = 0;
+    qint64 lagTotal = 0;
+    qint64 lagMax = 0;
+    int stallCount = 0;
+    Stall pending;
+    Stall last;
+};
+
+#endif // WATCHDOG_H